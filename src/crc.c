@@ -4,7 +4,7 @@
 uint8_t crc8(uint8_t msg[], size_t length, uint8_t init, uint8_t poly,
 	     uint8_t xor)
 {
-	int i;
+	size_t i;
 	uint8_t crc = init;
 	for (i = 0; i < length; ++i) {
 		crc = crc ^ msg[i];
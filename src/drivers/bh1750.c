@@ -29,9 +29,12 @@ enum bh1750_cmd {
 };
 
 static const int64_t MODE_TO_DEFAULT_MT_US[] = {
-	[BH1750_MODE_HRES1_CONT] = 120000, [BH1750_MODE_HRES2_CONT] = 120000,
-	[BH1750_MODE_LRES_CONT] = 16000,   [BH1750_MODE_HRES1_ONCE] = 120000,
-	[BH1750_MODE_HRES2_ONCE] = 120000, [BH1750_MODE_LRES_ONCE] = 16000
+	[BH1750_MODE_HRES1_CONT] = BH1750_HRES_MT_US_DEFAULT,
+	[BH1750_MODE_HRES2_CONT] = BH1750_HRES_MT_US_DEFAULT,
+	[BH1750_MODE_LRES_CONT] = BH1750_LRES_MT_US_DEFAULT,
+	[BH1750_MODE_HRES1_ONCE] = BH1750_HRES_MT_US_DEFAULT,
+	[BH1750_MODE_HRES2_ONCE] = BH1750_HRES_MT_US_DEFAULT,
+	[BH1750_MODE_LRES_ONCE] = BH1750_LRES_MT_US_DEFAULT
 };
 
 static const uint8_t MODE_TO_READ_CMD[] = {
@@ -68,16 +71,19 @@ static int bh1750_i2c_write_raw(bh1750_state_t *state, const uint8_t *src,
 {
 	int nbytes;
 
-	nbytes = i2c_write_blocking(state->i2c, BH1750_I2C_ADDRESS, src, len,
-				    false);
+	nbytes = i2c_write_timeout_us(state->i2c, BH1750_I2C_ADDRESS, src, len,
+				      false, BH1750_I2C_TIMEOUT_US);
 	if (nbytes == PICO_ERROR_GENERIC) {
 		pw_log(LOG_LEVEL_ERROR,
 		       "[%x] Failed to write to BH1750. Address not acknowledged.",
 		       src[0]);
+	} else if (nbytes == PICO_ERROR_TIMEOUT) {
+		pw_log(LOG_LEVEL_ERROR, "[%x] Timed out writing to BH1750.",
+		       src[0]);
 	} else if ((size_t)nbytes != len) {
 		pw_log(LOG_LEVEL_ERROR,
 		       "[%x] Wrote %d bytes to the BH1750 but %u was expected.",
-		       src[0], nbytes, len);
+		       src[0], nbytes, (uint)len);
 	}
 	return nbytes;
 }
@@ -86,15 +92,17 @@ static int bh1750_i2c_read_raw(bh1750_state_t *state, uint8_t *dest, size_t len)
 {
 	int nbytes;
 
-	nbytes = i2c_read_blocking(state->i2c, BH1750_I2C_ADDRESS, dest, len,
-				   false);
+	nbytes = i2c_read_timeout_us(state->i2c, BH1750_I2C_ADDRESS, dest, len,
+				     false, BH1750_I2C_TIMEOUT_US);
 	if (nbytes == PICO_ERROR_GENERIC) {
 		pw_log(LOG_LEVEL_ERROR,
 		       "Failed to read from BH1750. Address not acknowledged.");
+	} else if (nbytes == PICO_ERROR_TIMEOUT) {
+		pw_log(LOG_LEVEL_ERROR, "Timed out reading from BH1750.");
 	} else if ((size_t)nbytes != len) {
 		pw_log(LOG_LEVEL_ERROR,
 		       "Reaad %d bytes from the BH1750 but %u was expected.",
-		       nbytes, len);
+		       nbytes, (uint)len);
 	}
 	return nbytes;
 }
@@ -270,4 +278,20 @@ bool bh1750_mtreg_set(bh1750_state_t *state, uint8_t mtreg_new)
 
 uint8_t bh1750_mt_ms_set(bh1750_state_t *state, uint32_t mt_ms_new);
 
-void bh1750_reset(bh1750_state_t *state);
+void bh1750_measurement_abort(bh1750_state_t *state)
+{
+	state->measurement_active = false;
+}
+
+void bh1750_reset(bh1750_state_t *state)
+{
+	static const uint8_t reset_cmd = BH1750_CMD_RESET;
+
+	// Reset clears the data register and is only accepted while powered on
+	bh1750_power_up(state);
+	(void)bh1750_i2c_write_raw(state, &reset_cmd, 1);
+	if (bh1750_is_mode_once(state->mode)) {
+		bh1750_power_down(state);
+	}
+	state->measurement_active = false;
+}
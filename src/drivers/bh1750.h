@@ -23,6 +23,20 @@
 
 #define BH1750_I2C_SPEED_MAX_HZ (400000)
 #define BH1750_I2C_SPEED (100000)
+/* The longest transfer is 2 bytes, well under 1ms at standard mode. This
+ * only has to catch a bus that is held low.
+ */
+#define BH1750_I2C_TIMEOUT_US (3000)
+/* Most transfers one call makes, which bounds how long it can take on a
+ * hung bus. bh1750_read_raw() has to power up again and power down after.
+ */
+#define BH1750_CALL_TRANSFERS_MAX (5)
+
+/* Measurement times with the default MTreg. Changing MTreg scales them;
+ * bh1750_measurement_start() returns the one currently in effect.
+ */
+#define BH1750_HRES_MT_US_DEFAULT (120000)
+#define BH1750_LRES_MT_US_DEFAULT (16000)
 
 enum bh1750_mode {
 	BH1750_MODE_HRES1_CONT = 0,
@@ -61,6 +75,12 @@ uint32_t bh1750_raw_to_lux_centi(bh1750_state_t *state, uint16_t raw);
 bool bh1750_mtreg_set(bh1750_state_t *state, uint8_t mtreg_new);
 uint8_t bh1750_mt_ms_set(bh1750_state_t *state, uint32_t mt_ms_new);
 
+/* Forgets an active measurement without touching the bus, e.g. after a
+ * failed read. Nothing else can be started until that is done. The next
+ * start powers the device up and sends the measure command again.
+ */
+void bh1750_measurement_abort(bh1750_state_t *state);
+/* Like bh1750_measurement_abort() but also clears the data register */
 void bh1750_reset(bh1750_state_t *state);
 
 #endif /* _PICOWEATHER_DRIVERS_BH1750_H */
@@ -24,6 +24,8 @@ uint16_t s12sd_read_raw(uint gpio)
 {
 #if ADC_NDEVICES > 1
 	adc_select_input(gpio_pin_to_adc_input(gpio));
+#else
+	(void)gpio;
 #endif
 	return adc_read();
 }
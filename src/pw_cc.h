@@ -6,6 +6,10 @@
 #define pw_expect(expr, expect) __builtin_expect(expr, expect)
 
 #define pw_compiler_barrier() __asm__ __volatile__("" ::: "memory");
+#define pw_smp_rmb() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define pw_smp_wmb() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define pw_read_once(x) (*(const volatile pw_typeof(x) *)&(x))
+#define pw_write_once(x, v) (*(volatile pw_typeof(x) *)&(x) = (v))
 #define pw_unreachable() __builtin_unreachable()
 #define pw_assume_aligned(p, a) __builtin_assume_aligned(p, a)
 #define pw_prefetch(p) __builtin_prefetch(p)
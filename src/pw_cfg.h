@@ -18,11 +18,31 @@
 
 #define I2C_STANDARD_MODE_HZ (100000)
 
+/* Sensors registered in pw_sensors.h. Disabled sensors are compiled out
+ * entirely.
+ */
+#define S12SD_ENABLED (1)
 #define S12SD_GPIO_PIN ADC2_GPIO_PIN
+#define S12SD_PERIOD_MS (2000)
+/* The UV dose restarts from 0 this often, counted from boot */
+#define S12SD_UV_DOSE_WINDOW_MS (24 * 60 * 60 * 1000)
 
+#define BH1750_ENABLED (1)
+#define BH1750_PERIOD_MS (2000)
 #define BH1750_I2C_INST_N (0)
 #define BH1750_I2C_INST (i2c0_inst)
 #define BH1750_GPIO_PIN_I2C_SDA (12U)
 #define BH1750_GPIO_PIN_I2C_SCL (13U)
 
+/* Watchdog and deadline tracking, see pw_health.h. The RP2040 watchdog
+ * can't be set above ~8.3s.
+ */
+#define HEALTH_WATCHDOG_MS (5000)
+#define HEALTH_FEED_PERIOD_MS (1000)
+#define HEALTH_REPORT_PERIOD_MS (60000)
+#define HEALTH_DEADLINE_SLACK_US (10000)
+#define HEALTH_OP_BUDGET_US (20000)
+#define HEALTH_STALL_PERIODS (3)
+#define HEALTH_SCRATCH_RECORDS (3)
+
 #endif /* _PICOWEATHER_CFG_H */
@@ -0,0 +1,267 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pw_derived.h"
+
+#define ES_TABLE_T_MIN_CENTI_C PW_DERIVED_T_MIN_CENTI_C
+#define ES_TABLE_T_STEP_CENTI_C (250)
+#define ES_TABLE_LEN (sizeof(ES_TABLE_DPA) / sizeof(ES_TABLE_DPA[0]))
+#define ES_TABLE_T_MAX_CENTI_C \
+	(ES_TABLE_T_MIN_CENTI_C + (ES_TABLE_LEN - 1) * ES_TABLE_T_STEP_CENTI_C)
+
+#define KELVIN_OFFSET_CENTI (27315)
+#define RH_MAX_CENTI (10000)
+
+/* Saturation vapor pressure over water in deci-Pascals from -40C to 85C
+ * (the BME280 operating range) in 2.5C steps. Generated from the Magnus
+ * formula: es = 611.2 * exp(17.62 * T / (243.12 + T)) Pa.
+ *
+ * Linear interpolation between entries is within 0.7% of the formula at
+ * -40C and within 0.3% above 0C.
+ */
+static const uint32_t ES_TABLE_DPA[] = {
+	190,	246,	316,	403,	512,	646,	811,	1013,	1260,
+	1558,	1919,	2352,	2870,	3488,	4222,	5090,	6112,	7313,
+	8717,	10356,	12260,	14467,	17017,	19953,	23326,	27189,	31601,
+	36627,	42337,	48810,	56128,	64384,	73675,	84107,	95797,	108868,
+	123452, 139692, 157742, 177764, 199933, 224435, 251467, 281240, 313977,
+	349913, 389299, 432398, 479489, 530865, 586834,
+};
+_Static_assert(ES_TABLE_T_MAX_CENTI_C == PW_DERIVED_T_MAX_CENTI_C,
+	       "Table must cover the range advertised in pw_derived.h");
+
+inline static int32_t clamp_temp(int32_t temp_centi_c)
+{
+	if (temp_centi_c < ES_TABLE_T_MIN_CENTI_C) {
+		return ES_TABLE_T_MIN_CENTI_C;
+	}
+	if (temp_centi_c > (int32_t)ES_TABLE_T_MAX_CENTI_C) {
+		return ES_TABLE_T_MAX_CENTI_C;
+	}
+	return temp_centi_c;
+}
+
+inline static uint32_t clamp_rh(uint32_t rh_centi)
+{
+	return rh_centi > RH_MAX_CENTI ? RH_MAX_CENTI : rh_centi;
+}
+
+static uint32_t es_dpa(int32_t temp_centi_c)
+{
+	uint32_t offset;
+	uint32_t i;
+	uint32_t frac;
+
+	offset = clamp_temp(temp_centi_c) - ES_TABLE_T_MIN_CENTI_C;
+	i = offset / ES_TABLE_T_STEP_CENTI_C;
+	frac = offset % ES_TABLE_T_STEP_CENTI_C;
+	if (i >= ES_TABLE_LEN - 1) {
+		return ES_TABLE_DPA[ES_TABLE_LEN - 1];
+	}
+	return ES_TABLE_DPA[i] + ((ES_TABLE_DPA[i + 1] - ES_TABLE_DPA[i]) * frac +
+				  ES_TABLE_T_STEP_CENTI_C / 2) /
+					 ES_TABLE_T_STEP_CENTI_C;
+}
+
+/* Inverse of es_dpa(). Finds the temperature at which the saturation
+ * vapor pressure equals e_dpa, which is the dew point when e_dpa is the
+ * actual vapor pressure.
+ */
+static int32_t es_dpa_inverse(uint32_t e_dpa)
+{
+	uint32_t lo = 0;
+	uint32_t hi = ES_TABLE_LEN - 1;
+	uint32_t mid;
+	uint32_t span;
+
+	if (e_dpa <= ES_TABLE_DPA[0]) {
+		return ES_TABLE_T_MIN_CENTI_C;
+	}
+	if (e_dpa >= ES_TABLE_DPA[ES_TABLE_LEN - 1]) {
+		return ES_TABLE_T_MAX_CENTI_C;
+	}
+	// Find lo such that ES_TABLE_DPA[lo] <= e_dpa < ES_TABLE_DPA[lo + 1]
+	while (hi - lo > 1) {
+		mid = (lo + hi) / 2;
+		if (ES_TABLE_DPA[mid] <= e_dpa) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+	span = ES_TABLE_DPA[hi] - ES_TABLE_DPA[lo];
+	return ES_TABLE_T_MIN_CENTI_C + (int32_t)lo * ES_TABLE_T_STEP_CENTI_C +
+	       (int32_t)(((e_dpa - ES_TABLE_DPA[lo]) * ES_TABLE_T_STEP_CENTI_C +
+			  span / 2) /
+			 span);
+}
+
+inline static uint32_t vapor_pressure_dpa(int32_t temp_centi_c,
+					  uint32_t rh_centi)
+{
+	return ((uint64_t)es_dpa(temp_centi_c) * clamp_rh(rh_centi) +
+		RH_MAX_CENTI / 2) /
+	       RH_MAX_CENTI;
+}
+
+static uint32_t isqrt(uint32_t x)
+{
+	uint32_t res = 0;
+	uint32_t bit = 1UL << 30;
+
+	while (bit > x) {
+		bit >>= 2;
+	}
+	while (bit != 0) {
+		if (x >= res + bit) {
+			x -= res + bit;
+			res = (res >> 1) + bit;
+		} else {
+			res >>= 1;
+		}
+		bit >>= 2;
+	}
+	return res;
+}
+
+int32_t pw_derived_dew_point_centi_c(int32_t temp_centi_c, uint32_t rh_centi)
+{
+	return es_dpa_inverse(vapor_pressure_dpa(temp_centi_c, rh_centi));
+}
+
+uint16_t pw_derived_abs_hum_gpm3_q8(int32_t temp_centi_c, uint32_t rh_centi)
+{
+	/* AH = e / (Rv * T) = 2.16679 * e_Pa / T_K g/m^3.
+	 *
+	 * With e in dPa and T in centi-Kelvin the constant becomes
+	 * 2.16679 * 100 / 10 * 256 = 5547 for an 8.8 fixed point result.
+	 * The product stays below 2^32 for the whole table range.
+	 */
+	uint32_t e_dpa;
+	uint32_t temp_centi_k;
+	uint32_t ah_q8;
+
+	e_dpa = vapor_pressure_dpa(temp_centi_c, rh_centi);
+	temp_centi_k = clamp_temp(temp_centi_c) + KELVIN_OFFSET_CENTI;
+	ah_q8 = (5547 * e_dpa + temp_centi_k / 2) / temp_centi_k;
+	if (ah_q8 > UINT16_MAX) {
+		return UINT16_MAX;
+	}
+	return ah_q8;
+}
+
+int32_t pw_derived_heat_index_centi_c(int32_t temp_centi_c, uint32_t rh_centi)
+{
+	/* NWS heat index. The simple Steadman formula is used unless its
+	 * average with the temperature reaches 80F, then the Rothfusz
+	 * regression and its low/high humidity adjustments are used.
+	 *
+	 * The regression works in Fahrenheit and percent. All intermediate
+	 * products are kept in centi units and the coefficients are scaled
+	 * by 1e8.
+	 */
+	int64_t t = (int64_t)temp_centi_c * 9 / 5 + 3200;
+	int64_t r = clamp_rh(rh_centi);
+	int64_t t2;
+	int64_t r2;
+	int64_t hi;
+	int64_t d;
+
+	hi = (t + 6100 + (t - 6800) * 12 / 10 + r * 94 / 1000) / 2;
+	if (hi + t >= 2 * 8000) {
+		t2 = t * t / 100;
+		r2 = r * r / 100;
+		hi = (-4237900000LL * 100 + 204901523LL * t + 1014333127LL * r -
+		      22475541LL * (t * r / 100) - 683783LL * t2 -
+		      5481717LL * r2 + 122874LL * (t2 * r / 100) +
+		      85282LL * (t * r2 / 100) - 199LL * (t2 * r2 / 100)) /
+		     100000000LL;
+		if (r < 1300 && t > 8000 && t < 11200) {
+			d = t > 9500 ? t - 9500 : 9500 - t;
+			hi -= (1300 - r) *
+			      isqrt((uint32_t)((1700 - d) * 100000000 / 1700)) /
+			      40000;
+		} else if (r > 8500 && t > 8000 && t < 8700) {
+			hi += (r - 8500) * (8700 - t) / 5000;
+		}
+	}
+	return (int32_t)((hi - 3200) * 5 / 9);
+}
+
+void pw_derived_init(pw_derived_state_t *state)
+{
+	state->temp_centi_c = 0;
+	state->rh_centi = 0;
+	state->thermo_valid = false;
+	state->dew_point_centi_c = 0;
+	state->heat_index_centi_c = 0;
+	state->abs_hum_gpm3_q8 = 0;
+	state->uv_dose_centi_uvi_us = 0;
+	state->uv_dose_start_us = 0;
+	state->uv_time_last_us = 0;
+	state->uv_index_centi_last = 0;
+	state->uv_valid = false;
+}
+
+bool pw_derived_thermo_update(pw_derived_state_t *state, int32_t temp_centi_c,
+			      uint32_t rh_centi)
+{
+	uint16_t ah_q8;
+	bool ah_changed;
+
+	if (state->thermo_valid && state->temp_centi_c == temp_centi_c &&
+	    state->rh_centi == rh_centi) {
+		return false;
+	}
+	state->temp_centi_c = temp_centi_c;
+	state->rh_centi = rh_centi;
+	state->dew_point_centi_c =
+		pw_derived_dew_point_centi_c(temp_centi_c, rh_centi);
+	state->heat_index_centi_c =
+		pw_derived_heat_index_centi_c(temp_centi_c, rh_centi);
+
+	ah_q8 = pw_derived_abs_hum_gpm3_q8(temp_centi_c, rh_centi);
+	// The SGP30 treats 0 as "compensation disabled"
+	if (ah_q8 == 0) {
+		ah_q8 = 1;
+	}
+	ah_changed = !state->thermo_valid || ah_q8 != state->abs_hum_gpm3_q8;
+	state->abs_hum_gpm3_q8 = ah_q8;
+	state->thermo_valid = true;
+	return ah_changed;
+}
+
+void pw_derived_uv_update(pw_derived_state_t *state, uint32_t uv_index_centi,
+			  uint64_t now_us)
+{
+	uint64_t dt_us;
+
+	if (state->uv_valid && now_us > state->uv_time_last_us) {
+		dt_us = now_us - state->uv_time_last_us;
+		state->uv_dose_centi_uvi_us +=
+			(uint64_t)(state->uv_index_centi_last + uv_index_centi) *
+			dt_us / 2;
+	} else if (!state->uv_valid) {
+		state->uv_dose_start_us = now_us;
+	}
+	state->uv_index_centi_last = uv_index_centi;
+	state->uv_time_last_us = now_us;
+	state->uv_valid = true;
+}
+
+void pw_derived_uv_reset(pw_derived_state_t *state, uint64_t now_us)
+{
+	state->uv_dose_centi_uvi_us = 0;
+	state->uv_dose_start_us = now_us;
+}
+
+int32_t pw_derived_uv_dose_mj_m2(const pw_derived_state_t *state)
+{
+	uint64_t dose;
+
+	/* mJ/m^2 = UVI * 25 mW/m^2 * s = (centi_uvi / 100) * 25 * (us / 1e6)
+	 *        = centi_uvi * us / 4e6
+	 */
+	dose = state->uv_dose_centi_uvi_us / 4000000;
+	return dose > INT32_MAX ? INT32_MAX : (int32_t)dose;
+}
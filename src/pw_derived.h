@@ -0,0 +1,87 @@
+#ifndef _PICOWEATHER_DERIVED_H
+#define _PICOWEATHER_DERIVED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Derived metrics computed from the raw sensor readings. Everything here
+ * is integer only; the Magnus saturation vapor pressure curve is stored
+ * as a lookup table and linearly interpolated instead of calling expf().
+ *
+ * Units follow the drivers: temperatures are centi-degrees Celsius,
+ * relative humidity is centi-percent and the UV index is centi-UVI.
+ * Absolute humidity is g/m^3 in 8.8 fixed point, the same layout the
+ * SGP30 expects for humidity compensation.
+ *
+ * Each update only recomputes what its inputs affect, so it is cheap
+ * enough to run after every sample.
+ *
+ * Against the floating point formulas (checked by tools/hosttest):
+ * dew point within 0.11C, absolute humidity within 0.8% plus one 8.8 LSB
+ * and heat index within 0.15C, except right at the 80F switch to the
+ * Rothfusz regression where the two can pick different branches.
+ * Absolute humidity saturates at 255.99g/m^3, reached in saturated air above
+ * about 76C.
+ */
+
+/* Range of the saturation vapor pressure table. Temperatures outside of
+ * it are clamped. The dew point is clamped too: a dew point of
+ * PW_DERIVED_T_MIN_CENTI_C means it is at or below -40C, which happens in
+ * cold or very dry air, e.g. at 10% RH below -15C or at 1% RH below 16C.
+ */
+#define PW_DERIVED_T_MIN_CENTI_C (-4000)
+#define PW_DERIVED_T_MAX_CENTI_C (8500)
+
+struct pw_derived_state {
+	/* Last thermo inputs, used to skip recomputation */
+	int32_t temp_centi_c;
+	uint32_t rh_centi;
+	bool thermo_valid;
+
+	int32_t dew_point_centi_c;
+	int32_t heat_index_centi_c;
+	uint16_t abs_hum_gpm3_q8;
+
+	/* UV dose is the trapezoidal integral of the UV index over time,
+	 * since uv_dose_start_us
+	 */
+	uint64_t uv_dose_centi_uvi_us;
+	uint64_t uv_dose_start_us;
+	uint64_t uv_time_last_us;
+	uint32_t uv_index_centi_last;
+	bool uv_valid;
+};
+typedef struct pw_derived_state pw_derived_state_t;
+
+void pw_derived_init(pw_derived_state_t *state);
+
+/* Update dew point, absolute humidity and heat index from a new
+ * temperature and relative humidity sample. Returns true if the absolute
+ * humidity changed, i.e. when the sensor glue should pass it on to the
+ * SGP30.
+ */
+bool pw_derived_thermo_update(pw_derived_state_t *state, int32_t temp_centi_c,
+			      uint32_t rh_centi);
+
+/* Accumulate UV dose up to now_us using the new UV index sample. The
+ * first sample only sets the starting point.
+ */
+void pw_derived_uv_update(pw_derived_state_t *state, uint32_t uv_index_centi,
+			  uint64_t now_us);
+
+/* Start a new dose window at now_us. The last sample is kept, so the next
+ * update integrates from there into the new window.
+ */
+void pw_derived_uv_reset(pw_derived_state_t *state, uint64_t now_us);
+
+/* Erythemal UV dose in mJ/m^2 since the last reset. One UV index unit is
+ * 25 mW/m^2. Saturates at INT32_MAX so it can be published as a snapshot
+ * value; a day at UV index 15 is about 32.4e6 mJ/m^2.
+ */
+int32_t pw_derived_uv_dose_mj_m2(const pw_derived_state_t *state);
+
+int32_t pw_derived_dew_point_centi_c(int32_t temp_centi_c, uint32_t rh_centi);
+uint16_t pw_derived_abs_hum_gpm3_q8(int32_t temp_centi_c, uint32_t rh_centi);
+int32_t pw_derived_heat_index_centi_c(int32_t temp_centi_c, uint32_t rh_centi);
+
+#endif /* _PICOWEATHER_DERIVED_H */
@@ -0,0 +1,221 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <hardware/structs/watchdog.h>
+#include <hardware/watchdog.h>
+
+#include "pw_cfg.h"
+#include "pw_health.h"
+#include "pw_log.h"
+#include "pw_sensors.h"
+
+/* scratch[4..7] belong to the SDK and bootrom, 0..3 are ours. scratch[0]
+ * holds the header and the rest are a ring of records.
+ */
+#define HEALTH_SCRATCH_MAGIC (0x5057U)
+#define HEALTH_SCRATCH_HEADER (0)
+#define HEALTH_SCRATCH_FIRST (1)
+
+#define HEALTH_RECORD_ID_SHIFT (27)
+#define HEALTH_RECORD_EVENT_SHIFT (25)
+#define HEALTH_RECORD_EVENT_MASK (0x3U)
+#define HEALTH_RECORD_MS_MASK (0x1ffffffU)
+
+_Static_assert(HEALTH_SCRATCH_FIRST + HEALTH_SCRATCH_RECORDS <= 4,
+	       "Only watchdog scratch registers 0-3 are free");
+_Static_assert(PW_SENSOR_COUNT <= 32, "Sensor id must fit in 5 bits");
+
+static const char *const HEALTH_EVENT_NAMES[] = {
+	[PW_HEALTH_EVENT_MISS] = "deadline miss",
+	[PW_HEALTH_EVENT_OVERRUN] = "overrun",
+	[PW_HEALTH_EVENT_STALL] = "stall",
+};
+
+static pw_health_sensor_t health_sensors[PW_SENSOR_COUNT] = { 0 };
+static uint64_t health_report_last_us = 0;
+static bool health_stalled = false;
+
+inline static uint32_t scratch_header(uint32_t count, uint32_t head)
+{
+	return (HEALTH_SCRATCH_MAGIC << 16) | (count << 8) | head;
+}
+
+static void scratch_record_push(pw_sensor_id_t id, pw_health_event_t event,
+				uint64_t lateness_us)
+{
+	uint32_t header;
+	uint32_t count = 0;
+	uint32_t head = 0;
+	uint64_t ms;
+
+	header = watchdog_hw->scratch[HEALTH_SCRATCH_HEADER];
+	if ((header >> 16) == HEALTH_SCRATCH_MAGIC) {
+		count = (header >> 8) & 0xff;
+		head = header & 0xff;
+	}
+	ms = lateness_us / 1000;
+	if (ms > HEALTH_RECORD_MS_MASK) {
+		ms = HEALTH_RECORD_MS_MASK;
+	}
+	watchdog_hw->scratch[HEALTH_SCRATCH_FIRST + head] =
+		((uint32_t)id << HEALTH_RECORD_ID_SHIFT) |
+		((uint32_t)event << HEALTH_RECORD_EVENT_SHIFT) | (uint32_t)ms;
+	head = (head + 1) % HEALTH_SCRATCH_RECORDS;
+	if (count < HEALTH_SCRATCH_RECORDS) {
+		++count;
+	}
+	watchdog_hw->scratch[HEALTH_SCRATCH_HEADER] =
+		scratch_header(count, head);
+}
+
+static void scratch_records_dump(void)
+{
+	uint32_t header;
+	uint32_t count;
+	uint32_t head;
+	uint32_t i;
+	uint32_t record;
+	uint32_t id;
+	uint32_t event;
+
+	header = watchdog_hw->scratch[HEALTH_SCRATCH_HEADER];
+	if ((header >> 16) != HEALTH_SCRATCH_MAGIC) {
+		return;
+	}
+	count = (header >> 8) & 0xff;
+	head = header & 0xff;
+	if (count > HEALTH_SCRATCH_RECORDS || head >= HEALTH_SCRATCH_RECORDS) {
+		return;
+	}
+	// Oldest first
+	for (i = 0; i < count; ++i) {
+		record = watchdog_hw->scratch[HEALTH_SCRATCH_FIRST +
+					      (head + HEALTH_SCRATCH_RECORDS -
+					       count + i) %
+						      HEALTH_SCRATCH_RECORDS];
+		id = record >> HEALTH_RECORD_ID_SHIFT;
+		event = (record >> HEALTH_RECORD_EVENT_SHIFT) &
+			HEALTH_RECORD_EVENT_MASK;
+		if (id >= PW_SENSOR_COUNT || event > PW_HEALTH_EVENT_STALL) {
+			continue;
+		}
+		pw_log(LOG_LEVEL_WARN, "Before reset: %s %s by %ums.",
+		       pw_sensor_table[id].name, HEALTH_EVENT_NAMES[event],
+		       record & HEALTH_RECORD_MS_MASK);
+	}
+}
+
+static void health_event(pw_sensor_id_t id, pw_health_event_t event,
+			 uint64_t lateness_us)
+{
+	pw_log(LOG_LEVEL_WARN, "%s %s by %uus.", pw_sensor_table[id].name,
+	       HEALTH_EVENT_NAMES[event], (uint32_t)lateness_us);
+	scratch_record_push(id, event, lateness_us);
+}
+
+inline static uint64_t stall_limit_us(pw_sensor_id_t id)
+{
+	return (uint64_t)pw_sensor_table[id].period_ms * 1000 *
+		       HEALTH_STALL_PERIODS +
+	       pw_sensor_table[id].conv_us + HEALTH_DEADLINE_SLACK_US;
+}
+
+static void health_report(void)
+{
+	uint32_t id;
+	pw_health_sensor_t *sensor;
+
+	for (id = 0; id < PW_SENSOR_COUNT; ++id) {
+		sensor = &health_sensors[id];
+		pw_log(LOG_LEVEL_INFO,
+		       "Health %s: misses %u, overruns %u, failures %u, worst latency %uus",
+		       pw_sensor_table[id].name, sensor->misses,
+		       sensor->overruns, sensor->failures,
+		       sensor->latency_worst_us);
+	}
+}
+
+void pw_health_init(uint64_t now_us)
+{
+	uint32_t id;
+
+	if (watchdog_enable_caused_reboot()) {
+		pw_log(LOG_LEVEL_WARN, "Rebooted by the watchdog.");
+		scratch_records_dump();
+	}
+	watchdog_hw->scratch[HEALTH_SCRATCH_HEADER] = scratch_header(0, 0);
+
+	for (id = 0; id < PW_SENSOR_COUNT; ++id) {
+		health_sensors[id] = (pw_health_sensor_t){ 0 };
+		health_sensors[id].progress_last_us = now_us;
+	}
+	health_report_last_us = now_us;
+	health_stalled = false;
+	watchdog_enable(HEALTH_WATCHDOG_MS, true);
+}
+
+void pw_health_op(pw_sensor_id_t id, uint64_t due_us, uint64_t begin_us,
+		  uint64_t end_us, bool ok)
+{
+	pw_health_sensor_t *sensor = &health_sensors[id];
+	uint64_t latency_us;
+	uint64_t duration_us;
+
+	latency_us = begin_us > due_us ? begin_us - due_us : 0;
+	duration_us = end_us - begin_us;
+	if (latency_us > sensor->latency_worst_us) {
+		sensor->latency_worst_us = latency_us > UINT32_MAX ?
+						   UINT32_MAX :
+						   (uint32_t)latency_us;
+	}
+	if (latency_us > HEALTH_DEADLINE_SLACK_US) {
+		++sensor->misses;
+		health_event(id, PW_HEALTH_EVENT_MISS, latency_us);
+	}
+	if (duration_us > HEALTH_OP_BUDGET_US) {
+		++sensor->overruns;
+		health_event(id, PW_HEALTH_EVENT_OVERRUN, duration_us);
+	}
+	if (!ok) {
+		++sensor->failures;
+	}
+}
+
+void pw_health_progress(pw_sensor_id_t id, uint64_t now_us)
+{
+	health_sensors[id].progress_last_us = now_us;
+}
+
+void pw_health_poll(uint64_t now_us)
+{
+	uint32_t id;
+	uint64_t idle_us;
+	bool progressing = true;
+
+	for (id = 0; id < PW_SENSOR_COUNT; ++id) {
+		idle_us = now_us - health_sensors[id].progress_last_us;
+		if (idle_us > stall_limit_us(id)) {
+			progressing = false;
+			// Only record the first stall, the reset follows soon
+			if (!health_stalled) {
+				health_event(id, PW_HEALTH_EVENT_STALL,
+					     idle_us);
+			}
+		}
+	}
+	if (progressing) {
+		watchdog_update();
+	}
+	health_stalled = !progressing;
+
+	if (now_us - health_report_last_us >=
+	    (uint64_t)HEALTH_REPORT_PERIOD_MS * 1000) {
+		health_report_last_us = now_us;
+		health_report();
+	}
+}
+
+const pw_health_sensor_t *pw_health_sensor_get(pw_sensor_id_t id)
+{
+	return &health_sensors[id];
+}
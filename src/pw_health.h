@@ -0,0 +1,61 @@
+#ifndef _PICOWEATHER_HEALTH_H
+#define _PICOWEATHER_HEALTH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pw_sensors.h"
+
+/* Runtime health of the sensor tasks.
+ *
+ * The scheduler reports every start and read to this module with the
+ * time it was due and the time it actually ran. An operation that runs
+ * more than HEALTH_DEADLINE_SLACK_US late is a deadline miss, one that
+ * takes longer than HEALTH_OP_BUDGET_US is an overrun.
+ *
+ * A sensor makes progress when it is read successfully. The watchdog is
+ * only fed while every sensor has made progress within
+ * HEALTH_STALL_PERIODS of its period, so a sensor stuck in an error loop
+ * eventually resets the board.
+ *
+ * The last HEALTH_SCRATCH_RECORDS misses, overruns and stalls are kept in
+ * the watchdog scratch registers, which survive a watchdog reset, and are
+ * logged on the next boot.
+ */
+
+enum pw_health_event {
+	PW_HEALTH_EVENT_MISS = 0,
+	PW_HEALTH_EVENT_OVERRUN,
+	PW_HEALTH_EVENT_STALL,
+};
+typedef enum pw_health_event pw_health_event_t;
+
+struct pw_health_sensor {
+	uint64_t progress_last_us;
+	uint32_t misses;
+	uint32_t overruns;
+	uint32_t failures;
+	uint32_t latency_worst_us;
+};
+typedef struct pw_health_sensor pw_health_sensor_t;
+
+/* Logs the records left by a previous watchdog reset, then starts the
+ * watchdog.
+ */
+void pw_health_init(uint64_t now_us);
+
+/* Record one start or read of a sensor. due_us is when the scheduler
+ * wanted it to run, begin_us and end_us bracket the call.
+ */
+void pw_health_op(pw_sensor_id_t id, uint64_t due_us, uint64_t begin_us,
+		  uint64_t end_us, bool ok);
+void pw_health_progress(pw_sensor_id_t id, uint64_t now_us);
+
+/* Feeds the watchdog if every sensor is progressing and periodically logs
+ * the counters. Must be called at least every HEALTH_FEED_PERIOD_MS.
+ */
+void pw_health_poll(uint64_t now_us);
+
+const pw_health_sensor_t *pw_health_sensor_get(pw_sensor_id_t id);
+
+#endif /* _PICOWEATHER_HEALTH_H */
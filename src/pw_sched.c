@@ -0,0 +1,109 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pico/time.h>
+
+#include "pw_health.h"
+#include "pw_log.h"
+#include "pw_sched.h"
+#include "pw_sensors.h"
+
+static pw_sched_task_t sched_tasks[PW_SENSOR_COUNT] = { 0 };
+
+inline static uint64_t period_us(pw_sensor_id_t id)
+{
+	return (uint64_t)pw_sensor_table[id].period_ms * 1000;
+}
+
+inline static uint64_t sched_now_us(void)
+{
+	return to_us_since_boot(get_absolute_time());
+}
+
+/* Both return the time after the operation finished */
+static uint64_t sched_task_start(pw_sensor_id_t id, uint64_t now_us)
+{
+	pw_sched_task_t *task = &sched_tasks[id];
+	uint64_t due_us = task->start_due_us;
+	uint32_t conv_us = pw_sensor_table[id].conv_us;
+	uint64_t end_us;
+	bool ok;
+
+	task->start_due_us += period_us(id);
+	// Don't try to catch up on missed periods, just realign
+	if (task->start_due_us <= now_us) {
+		task->start_due_us = now_us + period_us(id);
+	}
+	ok = pw_sensor_start(id, now_us, &conv_us);
+	end_us = sched_now_us();
+	pw_health_op(id, due_us, now_us, end_us, ok);
+	if (!ok) {
+		pw_log(LOG_LEVEL_ERROR, "Failed to start %s.",
+		       pw_sensor_table[id].name);
+		return end_us;
+	}
+	task->converting = true;
+	// The conversion started somewhere in the call, count from its end
+	task->read_due_us = end_us + conv_us;
+	return end_us;
+}
+
+static uint64_t sched_task_read(pw_sensor_id_t id, uint64_t now_us)
+{
+	pw_sched_task_t *task = &sched_tasks[id];
+	uint64_t end_us;
+	bool ok;
+
+	task->converting = false;
+	ok = pw_sensor_read(id, now_us);
+	end_us = sched_now_us();
+	pw_health_op(id, task->read_due_us, now_us, end_us, ok);
+	if (!ok) {
+		pw_log(LOG_LEVEL_ERROR, "Failed to read %s.",
+		       pw_sensor_table[id].name);
+		return end_us;
+	}
+	pw_health_progress(id, end_us);
+	return end_us;
+}
+
+void pw_sched_init(uint64_t now_us)
+{
+	uint32_t id;
+
+	pw_sensors_init();
+	pw_health_init(now_us);
+	for (id = 0; id < PW_SENSOR_COUNT; ++id) {
+		sched_tasks[id].start_due_us = now_us;
+		sched_tasks[id].read_due_us = 0;
+		sched_tasks[id].converting = false;
+	}
+}
+
+uint64_t pw_sched_poll(uint64_t now_us)
+{
+	uint64_t next_us = UINT64_MAX;
+	uint64_t due_us;
+	uint32_t id;
+	pw_sched_task_t *task;
+
+	for (id = 0; id < PW_SENSOR_COUNT; ++id) {
+		task = &sched_tasks[id];
+		if (task->converting && now_us >= task->read_due_us) {
+			now_us = sched_task_read(id, now_us);
+		}
+		if (!task->converting && now_us >= task->start_due_us) {
+			now_us = sched_task_start(id, now_us);
+			// Sensors with no conversion time are read right away
+			if (task->converting && now_us >= task->read_due_us) {
+				now_us = sched_task_read(id, now_us);
+			}
+		}
+		due_us = task->converting ? task->read_due_us :
+					    task->start_due_us;
+		if (due_us < next_us) {
+			next_us = due_us;
+		}
+	}
+	return next_us;
+}
@@ -0,0 +1,30 @@
+#ifndef _PICOWEATHER_SCHED_H
+#define _PICOWEATHER_SCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pw_sensors.h"
+
+/* Cooperative scheduler over the sensor registry. Each sensor is started
+ * every period_ms and read once the conversion time reported by its start
+ * op has passed. A start that is more than a period late realigns the
+ * period instead of catching up. Nothing here sleeps; the caller sleeps
+ * until the time pw_sched_poll() returns.
+ */
+
+struct pw_sched_task {
+	uint64_t start_due_us;
+	uint64_t read_due_us;
+	bool converting;
+};
+typedef struct pw_sched_task pw_sched_task_t;
+
+void pw_sched_init(uint64_t now_us);
+
+/* Run every start and read that is due at now_us. Returns the time of the
+ * next event.
+ */
+uint64_t pw_sched_poll(uint64_t now_us);
+
+#endif /* _PICOWEATHER_SCHED_H */
@@ -0,0 +1,27 @@
+#ifndef _PICOWEATHER_SENSOR_LIST_H
+#define _PICOWEATHER_SENSOR_LIST_H
+
+#include "drivers/bh1750.h"
+#include "pw_cfg.h"
+
+/* The sensor registry, see pw_sensors.h for the entry format */
+
+#if S12SD_ENABLED
+#define PW_SENSOR_S12SD(X) \
+	X(s12sd, PW_BUS_ADC, 0, S12SD_GPIO_PIN, S12SD_PERIOD_MS, 0)
+#else
+#define PW_SENSOR_S12SD(X)
+#endif
+
+/* pw_sensor_bh1750_init() selects BH1750_MODE_HRES1_ONCE */
+#if BH1750_ENABLED
+#define PW_SENSOR_BH1750(X)                                   \
+	X(bh1750, PW_BUS_I2C, BH1750_I2C_INST_N, BH1750_I2C_ADDRESS, \
+	  BH1750_PERIOD_MS, BH1750_HRES_MT_US_DEFAULT)
+#else
+#define PW_SENSOR_BH1750(X)
+#endif
+
+#define PW_SENSORS(X) PW_SENSOR_S12SD(X) PW_SENSOR_BH1750(X)
+
+#endif /* _PICOWEATHER_SENSOR_LIST_H */
@@ -0,0 +1,139 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <hardware/adc.h>
+#include <hardware/gpio.h>
+#include <hardware/i2c.h>
+#include <pico/types.h>
+
+#include "drivers/bh1750.h"
+#include "drivers/s12sd.h"
+#include "pw_cfg.h"
+#include "pw_derived.h"
+#include "pw_log.h"
+#include "pw_sensors.h"
+#include "pw_snapshot.h"
+
+const pw_sensor_desc_t pw_sensor_table[PW_SENSOR_COUNT] = { PW_SENSORS(
+	PW_SENSOR_DESC) };
+
+void pw_sensors_init(void)
+{
+	uint32_t id;
+
+	for (id = 0; id < PW_SENSOR_COUNT; ++id) {
+		pw_sensor_init(id);
+	}
+}
+
+#if S12SD_ENABLED
+// Only the UV dose for now, the thermo metrics wait on a BME280 driver
+static pw_derived_state_t derived_state = { 0 };
+
+void pw_sensor_s12sd_init(void)
+{
+	pw_derived_init(&derived_state);
+	adc_init();
+	s12sd_init(S12SD_GPIO_PIN);
+	pw_log(LOG_LEVEL_TRACE, "Initialized ADC and S12SD peripheral.");
+}
+
+bool pw_sensor_s12sd_start(uint64_t now_us, uint32_t *conv_us)
+{
+	// The ADC conversion happens in the read, nothing to start
+	(void)now_us;
+	(void)conv_us;
+	return true;
+}
+
+bool pw_sensor_s12sd_read(uint64_t now_us)
+{
+	uint32_t uv_index_centi;
+	int32_t uv_dose_mj_m2;
+	float uv_index;
+
+	uv_index_centi = s12sd_read_uv_index_centi(S12SD_GPIO_PIN);
+	uv_index = (float)uv_index_centi / 100.0f;
+	pw_log(LOG_LEVEL_INFO, "UV Index: %0.2f", uv_index);
+	if (derived_state.uv_valid &&
+	    now_us - derived_state.uv_dose_start_us >=
+		    (uint64_t)S12SD_UV_DOSE_WINDOW_MS * 1000) {
+		pw_derived_uv_reset(&derived_state, now_us);
+	}
+	pw_derived_uv_update(&derived_state, uv_index_centi, now_us);
+	uv_dose_mj_m2 = pw_derived_uv_dose_mj_m2(&derived_state);
+	pw_log(LOG_LEVEL_INFO, "UV Dose: %d mJ/m^2", uv_dose_mj_m2);
+
+	pw_snapshot_set(PW_CHANNEL_UV_INDEX, uv_index_centi, now_us);
+	pw_snapshot_set(PW_CHANNEL_UV_DOSE, uv_dose_mj_m2, now_us);
+	return true;
+}
+#endif /* S12SD_ENABLED */
+
+#if BH1750_ENABLED
+_Static_assert(BH1750_CALL_TRANSFERS_MAX * BH1750_I2C_TIMEOUT_US <
+		       HEALTH_OP_BUDGET_US,
+	       "A hung bus must not make a BH1750 op overrun");
+
+static bh1750_state_t bh1750_state = { 0 };
+
+void pw_sensor_bh1750_init(void)
+{
+	uint bh1750_i2c_hz_actual;
+
+	gpio_set_function(BH1750_GPIO_PIN_I2C_SDA, GPIO_FUNC_I2C);
+	gpio_set_function(BH1750_GPIO_PIN_I2C_SCL, GPIO_FUNC_I2C);
+	bh1750_i2c_hz_actual =
+		i2c_init(&BH1750_I2C_INST, BH1750_I2C_SPEED_MAX_HZ);
+	pw_log(LOG_LEVEL_TRACE,
+	       "Initialized I2C%u for BH1750 with a preferred baudrate of %u.",
+	       BH1750_I2C_INST_N, BH1750_I2C_SPEED_MAX_HZ);
+	if (bh1750_i2c_hz_actual > BH1750_I2C_SPEED_MAX_HZ) {
+		bh1750_i2c_hz_actual = i2c_set_baudrate(&BH1750_I2C_INST,
+							I2C_STANDARD_MODE_HZ);
+		pw_log(LOG_LEVEL_WARN,
+		       "i2c_init(I2C%u) returned baudrate higher than BH1750 supports. Using standard mode baudrate.",
+		       BH1750_I2C_INST_N);
+	}
+	bh1750_init(&bh1750_state, &BH1750_I2C_INST);
+	// This only fails if there is an active measurement, no need to verify
+	(void)bh1750_mode_set(&bh1750_state, BH1750_MODE_HRES1_ONCE);
+	pw_log(LOG_LEVEL_TRACE,
+	       "Initialized I2C%u for BH1750 with an actual baudrate of %u and in mode %d.",
+	       BH1750_I2C_INST_N, bh1750_i2c_hz_actual, BH1750_MODE_HRES1_ONCE);
+}
+
+bool pw_sensor_bh1750_start(uint64_t now_us, uint32_t *conv_us)
+{
+	uint64_t mt_us;
+
+	(void)now_us;
+	// Depends on the mode and MTreg, so take it from the driver
+	mt_us = bh1750_measurement_start(&bh1750_state);
+	if (mt_us == 0) {
+		return false;
+	}
+	*conv_us = mt_us;
+	return true;
+}
+
+bool pw_sensor_bh1750_read(uint64_t now_us)
+{
+	uint32_t lux_centi;
+	float lux;
+
+	lux_centi = bh1750_read_lux_centi(&bh1750_state);
+	/* A failed read leaves the measurement active, which would fail
+	 * every later start. Give up on this sample only, without more bus
+	 * traffic in this op.
+	 */
+	if (bh1750_state.measurement_active) {
+		bh1750_measurement_abort(&bh1750_state);
+		return false;
+	}
+	lux = (float)lux_centi / 100.0f;
+	pw_log(LOG_LEVEL_INFO, "Lux: %0.2f", lux);
+	pw_snapshot_set(PW_CHANNEL_LUX, lux_centi, now_us);
+	return true;
+}
+#endif /* BH1750_ENABLED */
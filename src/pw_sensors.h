@@ -0,0 +1,138 @@
+#ifndef _PICOWEATHER_SENSORS_H
+#define _PICOWEATHER_SENSORS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pw_cc.h"
+#include "pw_cfg.h"
+
+/* Compile time sensor registry.
+ *
+ * Every sensor is one X-macro entry:
+ *   X(name, bus, bus_n, addr, period_ms, conv_us)
+ *
+ * name: Used to paste together the glue functions in pw_sensors.c:
+ *       pw_sensor_<name>_init(), pw_sensor_<name>_start() and
+ *       pw_sensor_<name>_read(). See PW_SENSOR_OPS_DECL for their
+ *       signatures.
+ * bus: The bus the sensor sits on (enum pw_bus).
+ * bus_n: Instance of the bus, e.g. 0 for i2c0.
+ * addr: I2C address, or the GPIO pin for analog sensors.
+ * period_ms: Time between measurement starts.
+ * conv_us: Expected time between the start and when the result can be
+ *          read. The start op can report the actual time if it depends on
+ *          the sensor's settings. 0 means the value is read right after
+ *          starting.
+ *
+ * The entries live in pw_sensor_list.h. To add a sensor, add an
+ * <NAME>_ENABLED switch to pw_cfg.h, an entry there, and its glue
+ * functions. Disabled entries expand to nothing so they cost no flash or
+ * RAM.
+ */
+
+// Angle brackets so host tests can put their own list first in the path
+#include <pw_sensor_list.h>
+
+enum pw_bus {
+	PW_BUS_ADC = 0,
+	PW_BUS_I2C,
+	PW_BUS_SPI,
+};
+typedef enum pw_bus pw_bus_t;
+
+#define PW_SENSOR_ID(name, ...) PW_SENSOR_ID_##name,
+enum pw_sensor_id { PW_SENSORS(PW_SENSOR_ID) PW_SENSOR_COUNT };
+#undef PW_SENSOR_ID
+typedef enum pw_sensor_id pw_sensor_id_t;
+
+struct pw_sensor_desc {
+	const char *name;
+	pw_bus_t bus;
+	uint8_t bus_n;
+	uint8_t addr;
+	uint32_t period_ms;
+	uint32_t conv_us;
+};
+typedef struct pw_sensor_desc pw_sensor_desc_t;
+
+/* Generates the pw_sensor_table initializer:
+ *   pw_sensor_table[PW_SENSOR_COUNT] = { PW_SENSORS(PW_SENSOR_DESC) };
+ */
+#define PW_SENSOR_DESC(name_, bus_, bus_n_, addr_, period_ms_, conv_us_) \
+	[PW_SENSOR_ID_##name_] = {                                       \
+		.name = #name_,                                          \
+		.bus = bus_,                                             \
+		.bus_n = bus_n_,                                         \
+		.addr = addr_,                                           \
+		.period_ms = period_ms_,                                 \
+		.conv_us = conv_us_,                                     \
+	},
+
+extern const pw_sensor_desc_t pw_sensor_table[PW_SENSOR_COUNT];
+
+void pw_sensors_init(void);
+
+/* start() is called with *conv_us set to the registry's conv_us and may
+ * replace it with the actual conversion time. Both return false on
+ * failure.
+ */
+#define PW_SENSOR_OPS_DECL(name, ...)                                       \
+	void pw_sensor_##name##_init(void);                                 \
+	bool pw_sensor_##name##_start(uint64_t now_us, uint32_t *conv_us); \
+	bool pw_sensor_##name##_read(uint64_t now_us);
+PW_SENSORS(PW_SENSOR_OPS_DECL)
+#undef PW_SENSOR_OPS_DECL
+
+/* Static dispatch on the sensor id. The switches are generated from the
+ * registry so the compiler sees direct calls, no function pointers.
+ */
+
+#define PW_SENSOR_CASE_INIT(name, ...) \
+	case PW_SENSOR_ID_##name:      \
+		pw_sensor_##name##_init(); \
+		return;
+
+PW_ATTR_ALWAYS_INLINE
+inline static void pw_sensor_init(pw_sensor_id_t id)
+{
+	switch (id) {
+		PW_SENSORS(PW_SENSOR_CASE_INIT)
+	default:
+		pw_unreachable();
+	}
+}
+#undef PW_SENSOR_CASE_INIT
+
+#define PW_SENSOR_CASE_START(name, ...) \
+	case PW_SENSOR_ID_##name:       \
+		return pw_sensor_##name##_start(now_us, conv_us);
+
+PW_ATTR_ALWAYS_INLINE
+inline static bool pw_sensor_start(pw_sensor_id_t id, uint64_t now_us,
+				   uint32_t *conv_us)
+{
+	switch (id) {
+		PW_SENSORS(PW_SENSOR_CASE_START)
+	default:
+		pw_unreachable();
+	}
+}
+#undef PW_SENSOR_CASE_START
+
+#define PW_SENSOR_CASE_READ(name, ...) \
+	case PW_SENSOR_ID_##name:      \
+		return pw_sensor_##name##_read(now_us);
+
+PW_ATTR_ALWAYS_INLINE
+inline static bool pw_sensor_read(pw_sensor_id_t id, uint64_t now_us)
+{
+	switch (id) {
+		PW_SENSORS(PW_SENSOR_CASE_READ)
+	default:
+		pw_unreachable();
+	}
+}
+#undef PW_SENSOR_CASE_READ
+
+#endif /* _PICOWEATHER_SENSORS_H */
@@ -0,0 +1,72 @@
+#include <stdint.h>
+
+#include "pw_cc.h"
+#include "pw_snapshot.h"
+
+struct pw_snapshot_latch {
+	uint32_t seq;
+	pw_snapshot_t copies[2];
+};
+
+static struct pw_snapshot_latch snapshot_latch = { 0 };
+// Only touched by the writer
+static pw_snapshot_t snapshot_staging = { 0 };
+
+inline static void snapshot_latch_advance(void)
+{
+	pw_smp_wmb();
+	pw_write_once(snapshot_latch.seq, snapshot_latch.seq + 1);
+	pw_smp_wmb();
+}
+
+void pw_snapshot_set(pw_channel_t channel, int32_t value,
+		     uint64_t timestamp_us)
+{
+	pw_reading_t *reading = &snapshot_staging.readings[channel];
+
+	reading->timestamp_us = timestamp_us;
+	reading->value = value;
+	reading->valid = true;
+}
+
+void pw_snapshot_invalidate(pw_channel_t channel)
+{
+	snapshot_staging.readings[channel].valid = false;
+}
+
+void pw_snapshot_publish(void)
+{
+	/* seq goes odd: readers switch to copies[1] while copies[0] is
+	 * written, then even: readers switch back while copies[1] is written.
+	 */
+	snapshot_latch_advance();
+	snapshot_latch.copies[0] = snapshot_staging;
+	snapshot_latch_advance();
+	snapshot_latch.copies[1] = snapshot_staging;
+}
+
+uint32_t pw_snapshot_read(pw_snapshot_t *out)
+{
+	uint32_t seq;
+
+	do {
+		seq = pw_read_once(snapshot_latch.seq);
+		pw_smp_rmb();
+		*out = snapshot_latch.copies[seq & 1];
+		pw_smp_rmb();
+	} while (pw_expect(pw_read_once(snapshot_latch.seq) != seq, 0));
+	return seq;
+}
+
+uint32_t pw_snapshot_read_channel(pw_channel_t channel, pw_reading_t *out)
+{
+	uint32_t seq;
+
+	do {
+		seq = pw_read_once(snapshot_latch.seq);
+		pw_smp_rmb();
+		*out = snapshot_latch.copies[seq & 1].readings[channel];
+		pw_smp_rmb();
+	} while (pw_expect(pw_read_once(snapshot_latch.seq) != seq, 0));
+	return seq;
+}
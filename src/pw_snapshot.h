@@ -0,0 +1,62 @@
+#ifndef _PICOWEATHER_SNAPSHOT_H
+#define _PICOWEATHER_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Global snapshot of the latest reading for every channel.
+ *
+ * The snapshot is published with a latched sequence lock: there are two
+ * copies of the data and the sequence number selects which one readers
+ * use while the writer updates the other. The writer never waits on
+ * readers, and a reader that interrupts the writer (an IRQ on the same
+ * core) always finds a stable copy instead of spinning. Readers on the
+ * other core retry only if the writer passed them during the copy.
+ *
+ * There must be a single writer. Values are staged with
+ * pw_snapshot_set() and become visible together on pw_snapshot_publish(),
+ * so readers always see a consistent multi-channel view.
+ */
+
+/* Fixed point unit of each channel is noted next to it */
+enum pw_channel {
+	PW_CHANNEL_UV_INDEX = 0, /* centi-UVI */
+	PW_CHANNEL_UV_DOSE, /* mJ/m^2 */
+	PW_CHANNEL_LUX, /* centi-lux */
+	PW_CHANNEL_TEMPERATURE, /* centi-C */
+	PW_CHANNEL_HUMIDITY, /* centi-% RH */
+	PW_CHANNEL_PRESSURE, /* Pa */
+	PW_CHANNEL_DEW_POINT, /* centi-C */
+	PW_CHANNEL_HEAT_INDEX, /* centi-C */
+	PW_CHANNEL_ABS_HUMIDITY, /* g/m^3, 8.8 fixed point */
+	PW_CHANNEL_CO2EQ, /* ppm */
+	PW_CHANNEL_TVOC, /* ppb */
+	PW_CHANNEL_COUNT
+};
+typedef enum pw_channel pw_channel_t;
+
+struct pw_reading {
+	uint64_t timestamp_us;
+	int32_t value;
+	bool valid;
+};
+typedef struct pw_reading pw_reading_t;
+
+struct pw_snapshot {
+	pw_reading_t readings[PW_CHANNEL_COUNT];
+};
+typedef struct pw_snapshot pw_snapshot_t;
+
+/* Writer side. Only one context may call these. */
+void pw_snapshot_set(pw_channel_t channel, int32_t value,
+		     uint64_t timestamp_us);
+void pw_snapshot_invalidate(pw_channel_t channel);
+void pw_snapshot_publish(void);
+
+/* Reader side. Safe from any core or interrupt. Both return the sequence
+ * number the data was read under; it increases by 2 on every publish.
+ */
+uint32_t pw_snapshot_read(pw_snapshot_t *out);
+uint32_t pw_snapshot_read_channel(pw_channel_t channel, pw_reading_t *out);
+
+#endif /* _PICOWEATHER_SNAPSHOT_H */
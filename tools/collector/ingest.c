@@ -0,0 +1,429 @@
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "ingest.h"
+#include "pool.h"
+#include "store.h"
+#include "wire.h"
+
+#define INGEST_UDP_BATCH (32)
+#define INGEST_POLL_MS (100)
+#define INGEST_RCVBUF (8 * 1024 * 1024)
+#define INGEST_QUERY_LEN (256)
+#define INGEST_REOPEN_MS (1000)
+
+inline static bool ingest_stopping(pw_ingest_t *ingest)
+{
+	return __atomic_load_n(&ingest->stopping, __ATOMIC_ACQUIRE);
+}
+
+/* Only picks the worker, so a sender's datagrams stay in order */
+inline static uint32_t sender_shard(const struct sockaddr_in *addr)
+{
+	return (ntohl(addr->sin_addr.s_addr) * 2654435761U) ^
+	       ntohs(addr->sin_port);
+}
+
+static int udp_bind(const char *host, uint16_t *port)
+{
+	struct sockaddr_in addr = { 0 };
+	socklen_t addr_len = sizeof(addr);
+	struct timeval tv = { .tv_sec = 0, .tv_usec = INGEST_POLL_MS * 1000 };
+	int rcvbuf = INGEST_RCVBUF;
+	int fd;
+
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(*port);
+	if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+		fprintf(stderr, "Invalid IPv4 address %s.\n", host);
+		return -1;
+	}
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0) {
+		perror("socket");
+		return -1;
+	}
+	// Receive timeouts let the threads notice pw_ingest_stop()
+	(void)setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	(void)setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+		perror("bind");
+		close(fd);
+		return -1;
+	}
+	(void)getsockname(fd, (struct sockaddr *)&addr, &addr_len);
+	*port = ntohs(addr.sin_port);
+	return fd;
+}
+
+void pw_ingest_init(pw_ingest_t *ingest, pw_pool_t *pool, pw_store_t *store)
+{
+	ingest->pool = pool;
+	ingest->store = store;
+	ingest->udp_fd = -1;
+	ingest->query_fd = -1;
+	ingest->ttys_len = 0;
+	ingest->started = false;
+	ingest->stopping = false;
+	ingest->datagrams = 0;
+}
+
+bool pw_ingest_udp_open(pw_ingest_t *ingest, const char *host,
+			uint16_t *port)
+{
+	ingest->udp_fd = udp_bind(host, port);
+	return ingest->udp_fd >= 0;
+}
+
+bool pw_ingest_query_open(pw_ingest_t *ingest, const char *host,
+			  uint16_t *port)
+{
+	ingest->query_fd = udp_bind(host, port);
+	return ingest->query_fd >= 0;
+}
+
+/* Opening doesn't wait for carrier, or for a writer on a fifo. Returns -1
+ * with errno set on failure.
+ */
+static int tty_open(const char *path)
+{
+	struct termios tio;
+	int fd;
+
+	fd = open(path, O_RDONLY | O_NOCTTY | O_CLOEXEC | O_NONBLOCK);
+	if (fd < 0) {
+		return -1;
+	}
+	// Not a tty (e.g. a fifo) is fine, there is just nothing to set up
+	if (tcgetattr(fd, &tio) == 0) {
+		cfmakeraw(&tio);
+		cfsetspeed(&tio, B115200);
+		// Ignore the modem lines so reads don't wait for carrier
+		tio.c_cflag |= CLOCAL | CREAD;
+		(void)tcsetattr(fd, TCSANOW, &tio);
+	}
+	(void)fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+	return fd;
+}
+
+bool pw_ingest_tty_add(pw_ingest_t *ingest, const char *path,
+		       uint32_t station)
+{
+	struct pw_ingest_tty *tty;
+	int fd;
+
+	if (ingest->ttys_len == PW_INGEST_TTYS_MAX) {
+		fprintf(stderr, "Too many ttys, at most %u are supported.\n",
+			PW_INGEST_TTYS_MAX);
+		return false;
+	}
+	fd = tty_open(path);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to open %s: %s\n", path,
+			strerror(errno));
+		return false;
+	}
+	tty = &ingest->ttys[ingest->ttys_len];
+	tty->ingest = ingest;
+	tty->path = path;
+	tty->fd = fd;
+	tty->station = station;
+	pw_stream_init(&tty->stream);
+	++ingest->ttys_len;
+	return true;
+}
+
+static void *udp_main(void *arg)
+{
+	pw_ingest_t *ingest = arg;
+	pw_buf_t *bufs[INGEST_UDP_BATCH] = { 0 };
+	struct mmsghdr msgs[INGEST_UDP_BATCH];
+	struct iovec iovs[INGEST_UDP_BATCH];
+	struct sockaddr_in addrs[INGEST_UDP_BATCH];
+	pw_buf_t *buf;
+	pw_parse_stats_t stats = { 0 };
+	int n;
+	int i;
+
+	while (!ingest_stopping(ingest)) {
+		for (i = 0; i < INGEST_UDP_BATCH; ++i) {
+			if (bufs[i] == NULL) {
+				bufs[i] = pw_pool_buf_get(ingest->pool);
+				if (bufs[i] == NULL) {
+					goto out;
+				}
+			}
+			iovs[i].iov_base = bufs[i]->data;
+			iovs[i].iov_len = PW_BUF_SIZE;
+			memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+			msgs[i].msg_hdr.msg_name = &addrs[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+		}
+		n = recvmmsg(ingest->udp_fd, msgs, INGEST_UDP_BATCH,
+			     MSG_WAITFORONE, NULL);
+		if (n <= 0) {
+			continue;
+		}
+		for (i = 0; i < n; ++i) {
+			buf = bufs[i];
+			bufs[i] = NULL;
+			// Larger than a buffer, the rest of it is gone
+			if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+				++stats.errors;
+				pw_pool_buf_put(ingest->pool, buf);
+				continue;
+			}
+			buf->len = msgs[i].msg_len;
+			buf->station = PW_STATION_NONE;
+			buf->stream = NULL;
+			// A datagram always ends the last line
+			if (!pw_wire_is_binary(buf->data, buf->len) &&
+			    buf->len != 0 && buf->data[buf->len - 1] != '\n') {
+				buf->data[buf->len++] = '\n';
+			}
+			pw_pool_submit(ingest->pool, buf,
+				       sender_shard(&addrs[i]));
+		}
+		__atomic_fetch_add(&ingest->datagrams, n, __ATOMIC_RELAXED);
+		if (stats.errors != 0) {
+			pw_pool_stats_add(ingest->pool, &stats);
+			stats.errors = 0;
+		}
+		// Move the unused buffers to the front for the next batch
+		for (i = 0; i < INGEST_UDP_BATCH - n; ++i) {
+			bufs[i] = bufs[i + n];
+			bufs[i + n] = NULL;
+		}
+	}
+out:
+	for (i = 0; i < INGEST_UDP_BATCH; ++i) {
+		if (bufs[i] != NULL) {
+			pw_pool_buf_put(ingest->pool, bufs[i]);
+		}
+	}
+	return NULL;
+}
+
+/* Closes the tty and retries opening it until that works or the ingest
+ * stops. Returns false if it stopped.
+ */
+static bool tty_reopen(struct pw_ingest_tty *tty)
+{
+	pw_ingest_t *ingest = tty->ingest;
+	uint32_t waited_ms = 0;
+	bool logged = false;
+
+	close(tty->fd);
+	tty->fd = -1;
+	while (!ingest_stopping(ingest)) {
+		usleep(INGEST_POLL_MS * 1000);
+		waited_ms += INGEST_POLL_MS;
+		if (waited_ms < INGEST_REOPEN_MS) {
+			continue;
+		}
+		waited_ms = 0;
+		tty->fd = tty_open(tty->path);
+		if (tty->fd >= 0) {
+			fprintf(stderr, "Reopened %s.\n", tty->path);
+			return true;
+		}
+		// Once is enough while it stays gone
+		if (!logged) {
+			fprintf(stderr, "Failed to reopen %s: %s\n",
+				tty->path, strerror(errno));
+			logged = true;
+		}
+	}
+	return false;
+}
+
+/* Reads into pool buffers, so a full pool holds the tty back the same way
+ * it does the UDP thread. The tty's index is its shard key.
+ */
+static void *tty_main(void *arg)
+{
+	struct pw_ingest_tty *tty = arg;
+	pw_ingest_t *ingest = tty->ingest;
+	struct pollfd pfd = { .events = POLLIN };
+	pw_buf_t *buf = NULL;
+	ssize_t n;
+
+	while (!ingest_stopping(ingest)) {
+		if (buf == NULL) {
+			buf = pw_pool_buf_get(ingest->pool);
+			if (buf == NULL) {
+				break;
+			}
+		}
+		pfd.fd = tty->fd;
+		if (poll(&pfd, 1, INGEST_POLL_MS) <= 0) {
+			continue;
+		}
+		n = read(tty->fd, buf->data, PW_BUF_SIZE);
+		if (n <= 0) {
+			if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+				fprintf(stderr,
+					"tty %s for station %u closed, reopening.\n",
+					tty->path, tty->station);
+				if (!tty_reopen(tty)) {
+					break;
+				}
+			}
+			continue;
+		}
+		buf->len = n;
+		buf->station = tty->station;
+		buf->stream = &tty->stream;
+		pw_pool_submit(ingest->pool, buf, tty - ingest->ttys);
+		buf = NULL;
+	}
+	if (buf != NULL) {
+		pw_pool_buf_put(ingest->pool, buf);
+	}
+	return NULL;
+}
+
+static int query_answer(pw_ingest_t *ingest, char *cmd, char *reply,
+			size_t reply_len)
+{
+	char channel_name[32];
+	uint32_t station;
+	uint32_t window_ms;
+	pw_channel_t channel;
+	pw_sample_t sample;
+	pw_aggregate_t agg;
+	pw_parse_stats_t stats;
+	uint64_t rejected;
+
+	if (sscanf(cmd, "latest %u %31s", &station, channel_name) == 2) {
+		if (!pw_channel_from_name(channel_name, &channel)) {
+			return snprintf(reply, reply_len, "error channel\n");
+		}
+		if (!pw_store_latest(ingest->store, station, channel,
+				     &sample)) {
+			return snprintf(reply, reply_len, "none\n");
+		}
+		return snprintf(reply, reply_len, "%u %s %u %d %llu\n",
+				station, channel_name, sample.timestamp_ms,
+				sample.value,
+				(unsigned long long)(pw_clock_ns() -
+						     sample.ingest_ns) /
+					1000000);
+	}
+	if (sscanf(cmd, "window %u %31s %u", &station, channel_name,
+		   &window_ms) == 3) {
+		if (!pw_channel_from_name(channel_name, &channel)) {
+			return snprintf(reply, reply_len, "error channel\n");
+		}
+		if (!pw_store_window(ingest->store, station, channel,
+				     window_ms, &agg)) {
+			return snprintf(reply, reply_len, "none\n");
+		}
+		return snprintf(reply, reply_len, "%u %s %u %d %d %lld\n",
+				station, channel_name, agg.count, agg.min,
+				agg.max, (long long)(agg.sum / agg.count));
+	}
+	if (strncmp(cmd, "stats", 5) == 0) {
+		pw_pool_stats(ingest->pool, &stats, &rejected);
+		return snprintf(
+			reply, reply_len,
+			"stations %u datagrams %llu records %llu errors %llu rejected %llu\n",
+			pw_store_station_count(ingest->store),
+			(unsigned long long)__atomic_load_n(&ingest->datagrams,
+							    __ATOMIC_RELAXED),
+			(unsigned long long)stats.records,
+			(unsigned long long)stats.errors,
+			(unsigned long long)rejected);
+	}
+	return snprintf(reply, reply_len, "error command\n");
+}
+
+static void *query_main(void *arg)
+{
+	pw_ingest_t *ingest = arg;
+	struct sockaddr_in addr;
+	socklen_t addr_len;
+	char cmd[INGEST_QUERY_LEN];
+	char reply[INGEST_QUERY_LEN];
+	ssize_t n;
+	int reply_n;
+
+	while (!ingest_stopping(ingest)) {
+		addr_len = sizeof(addr);
+		n = recvfrom(ingest->query_fd, cmd, sizeof(cmd) - 1, 0,
+			     (struct sockaddr *)&addr, &addr_len);
+		if (n <= 0) {
+			continue;
+		}
+		cmd[n] = '\0';
+		reply_n = query_answer(ingest, cmd, reply, sizeof(reply));
+		if (reply_n > 0) {
+			(void)sendto(ingest->query_fd, reply,
+				     (size_t)reply_n < sizeof(reply) ?
+					     (size_t)reply_n :
+					     sizeof(reply) - 1,
+				     0, (struct sockaddr *)&addr, addr_len);
+		}
+	}
+	return NULL;
+}
+
+void pw_ingest_start(pw_ingest_t *ingest)
+{
+	uint32_t i;
+
+	ingest->started = true;
+	if (ingest->udp_fd >= 0) {
+		pthread_create(&ingest->udp_thread, NULL, udp_main, ingest);
+	}
+	if (ingest->query_fd >= 0) {
+		pthread_create(&ingest->query_thread, NULL, query_main,
+			       ingest);
+	}
+	for (i = 0; i < ingest->ttys_len; ++i) {
+		pthread_create(&ingest->ttys[i].thread, NULL, tty_main,
+			       &ingest->ttys[i]);
+	}
+}
+
+void pw_ingest_stop(pw_ingest_t *ingest)
+{
+	uint32_t i;
+
+	__atomic_store_n(&ingest->stopping, true, __ATOMIC_RELEASE);
+	if (ingest->udp_fd >= 0) {
+		if (ingest->started) {
+			pthread_join(ingest->udp_thread, NULL);
+		}
+		close(ingest->udp_fd);
+	}
+	if (ingest->query_fd >= 0) {
+		if (ingest->started) {
+			pthread_join(ingest->query_thread, NULL);
+		}
+		close(ingest->query_fd);
+	}
+	for (i = 0; i < ingest->ttys_len; ++i) {
+		if (ingest->started) {
+			pthread_join(ingest->ttys[i].thread, NULL);
+		}
+		if (ingest->ttys[i].fd >= 0) {
+			close(ingest->ttys[i].fd);
+		}
+	}
+}
@@ -0,0 +1,72 @@
+#ifndef _PICOWEATHER_COLLECTOR_INGEST_H
+#define _PICOWEATHER_COLLECTOR_INGEST_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pool.h"
+#include "store.h"
+
+/* Receivers feeding the worker pool, plus the query responder.
+ *
+ * UDP: one thread receives datagrams in batches with recvmmsg() straight
+ * into pool buffers. Datagrams are sharded by sender. The sender's address
+ * doesn't name a station: text lines must carry an "@<station>" prefix,
+ * and frames carry their station id. Datagrams larger than a buffer are
+ * dropped and counted as errors.
+ *
+ * Serial: one thread per tty reads into pool buffers like UDP does, all
+ * sharded to the same worker, which carries partial lines and frames from
+ * one buffer into the next. The station id for text lines is given when
+ * the tty is added. A tty that closes or fails is reopened until it is
+ * back, e.g. after a USB adapter was plugged in again.
+ *
+ * Query: a UDP socket answering one text command per datagram:
+ *   latest <station> <channel>
+ *   window <station> <channel> <ms>
+ *   stats
+ */
+
+#define PW_INGEST_TTYS_MAX (64)
+
+struct pw_ingest_tty {
+	struct pw_ingest *ingest;
+	pthread_t thread;
+	// Kept for reopening, so it must outlive the ingest
+	const char *path;
+	int fd;
+	uint32_t station;
+	pw_stream_t stream;
+};
+
+struct pw_ingest {
+	pw_pool_t *pool;
+	pw_store_t *store;
+	int udp_fd;
+	int query_fd;
+	pthread_t udp_thread;
+	pthread_t query_thread;
+	struct pw_ingest_tty ttys[PW_INGEST_TTYS_MAX];
+	uint32_t ttys_len;
+	bool started;
+	bool stopping;
+	uint64_t datagrams;
+};
+typedef struct pw_ingest pw_ingest_t;
+
+void pw_ingest_init(pw_ingest_t *ingest, pw_pool_t *pool, pw_store_t *store);
+
+/* Port 0 picks a free port; the bound port is returned through port */
+bool pw_ingest_udp_open(pw_ingest_t *ingest, const char *host,
+			uint16_t *port);
+bool pw_ingest_query_open(pw_ingest_t *ingest, const char *host,
+			  uint16_t *port);
+bool pw_ingest_tty_add(pw_ingest_t *ingest, const char *path,
+		       uint32_t station);
+
+void pw_ingest_start(pw_ingest_t *ingest);
+/* Joins every receiver. The pool can be stopped afterwards. */
+void pw_ingest_stop(pw_ingest_t *ingest);
+
+#endif /* _PICOWEATHER_COLLECTOR_INGEST_H */
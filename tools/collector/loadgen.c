@@ -0,0 +1,236 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "loadgen.h"
+#include "pool.h"
+#include "wire.h"
+
+struct sim_station {
+	int fd;
+	uint32_t id;
+	bool binary;
+	uint64_t due_ns;
+	uint32_t boot_offset_ms;
+	uint32_t uv_index_centi;
+	uint32_t lux_centi;
+	uint32_t uv_dose_mj_m2;
+	uint32_t rng;
+};
+
+struct loadgen_thread {
+	const pw_loadgen_cfg_t *cfg;
+	pthread_t thread;
+	struct sim_station *stations;
+	uint32_t stations_len;
+	uint64_t start_ns;
+	pw_loadgen_stats_t stats;
+};
+
+inline static uint32_t xorshift32(uint32_t *state)
+{
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+static void sim_step(struct sim_station *st)
+{
+	// Small random walks in plausible ranges
+	st->uv_index_centi = (st->uv_index_centi + xorshift32(&st->rng) % 21 +
+			      1100 - 10) %
+			     1100;
+	st->lux_centi = (st->lux_centi + xorshift32(&st->rng) % 2001 +
+			 10000000 - 1000) %
+			10000000;
+	st->uv_dose_mj_m2 += st->uv_index_centi / 100;
+}
+
+static size_t sim_format(const struct sim_station *st, uint32_t ts_ms,
+			 int32_t dose, char *out, size_t out_len)
+{
+	pw_record_t record;
+	int n;
+
+	if (st->binary) {
+		record.station = st->id;
+		record.timestamp_ms = ts_ms;
+		record.channel = PW_CHANNEL_UV_INDEX;
+		record.value = st->uv_index_centi;
+		pw_wire_encode(&record, (uint8_t *)out);
+		record.channel = PW_CHANNEL_UV_DOSE;
+		record.value = dose;
+		pw_wire_encode(&record, (uint8_t *)out + PW_WIRE_FRAME_LEN);
+		record.channel = PW_CHANNEL_LUX;
+		record.value = st->lux_centi;
+		pw_wire_encode(&record,
+			       (uint8_t *)out + 2 * PW_WIRE_FRAME_LEN);
+		return 3 * PW_WIRE_FRAME_LEN;
+	}
+	// Same lines pw_log() prints, prefixed with the station id
+	n = snprintf(out, out_len,
+		     "@%u [%ums] UV Index: %u.%02u\n"
+		     "@%u [%ums] UV Dose: %d mJ/m^2\n"
+		     "@%u [%ums] Lux: %u.%02u\n",
+		     st->id, ts_ms, st->uv_index_centi / 100,
+		     st->uv_index_centi % 100, st->id, ts_ms, dose, st->id,
+		     ts_ms, st->lux_centi / 100, st->lux_centi % 100);
+	return n < 0 ? 0 : (size_t)n;
+}
+
+static void *loadgen_main(void *arg)
+{
+	struct loadgen_thread *lt = arg;
+	const pw_loadgen_cfg_t *cfg = lt->cfg;
+	uint64_t period_ns = cfg->rate_hz ? 1000000000ULL / cfg->rate_hz : 0;
+	uint64_t end_ns = lt->start_ns + (uint64_t)cfg->duration_ms * 1000000;
+	uint64_t now_ns;
+	uint64_t next_ns;
+	struct sim_station *st;
+	struct timespec ts;
+	char out[256];
+	size_t len;
+	uint32_t ts_ms;
+	int32_t dose;
+	uint32_t i;
+
+	while ((now_ns = pw_clock_ns()) < end_ns) {
+		next_ns = end_ns;
+		for (i = 0; i < lt->stations_len; ++i) {
+			st = &lt->stations[i];
+			if (st->due_ns > now_ns) {
+				next_ns = st->due_ns < next_ns ? st->due_ns :
+								 next_ns;
+				continue;
+			}
+			st->due_ns += period_ns;
+			if (st->due_ns < now_ns) {
+				st->due_ns = now_ns + period_ns;
+			}
+			next_ns = st->due_ns < next_ns ? st->due_ns : next_ns;
+			sim_step(st);
+			ts_ms = st->boot_offset_ms +
+				(now_ns - lt->start_ns) / 1000000;
+			// Stamp as late as possible to measure only the trip
+			dose = cfg->bench ? (int32_t)pw_loadgen_bench_stamp(
+						    pw_clock_ns()) :
+					    (int32_t)st->uv_dose_mj_m2;
+			len = sim_format(st, ts_ms, dose, out, sizeof(out));
+			if (send(st->fd, out, len, 0) < 0) {
+				++lt->stats.send_errors;
+				continue;
+			}
+			++lt->stats.datagrams;
+			lt->stats.records += PW_LOADGEN_RECORDS_PER_DATAGRAM;
+		}
+		if (period_ns != 0 && next_ns > now_ns) {
+			ts.tv_sec = next_ns / 1000000000ULL;
+			ts.tv_nsec = next_ns % 1000000000ULL;
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts,
+					NULL);
+		}
+	}
+	return NULL;
+}
+
+static bool station_open(struct sim_station *st, const struct sockaddr_in *dst)
+{
+	st->fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (st->fd < 0) {
+		perror("socket");
+		return false;
+	}
+	if (connect(st->fd, (const struct sockaddr *)dst, sizeof(*dst)) != 0) {
+		perror("connect");
+		close(st->fd);
+		return false;
+	}
+	return true;
+}
+
+bool pw_loadgen_run(const pw_loadgen_cfg_t *cfg, pw_loadgen_stats_t *stats)
+{
+	struct sockaddr_in dst = { 0 };
+	struct sim_station *stations;
+	struct loadgen_thread *threads;
+	uint32_t per_thread;
+	uint32_t opened = 0;
+	uint64_t start_ns;
+	bool ok = false;
+	uint32_t i;
+
+	dst.sin_family = AF_INET;
+	dst.sin_port = htons(cfg->port);
+	if (inet_pton(AF_INET, cfg->host, &dst.sin_addr) != 1) {
+		fprintf(stderr, "Invalid IPv4 address %s.\n", cfg->host);
+		return false;
+	}
+	stations = calloc(cfg->stations, sizeof(*stations));
+	threads = calloc(cfg->threads, sizeof(*threads));
+	if (stations == NULL || threads == NULL) {
+		goto out;
+	}
+
+	start_ns = pw_clock_ns();
+	for (i = 0; i < cfg->stations; ++i, ++opened) {
+		if (!station_open(&stations[i], &dst)) {
+			goto out;
+		}
+		stations[i].id = cfg->station_first + i;
+		stations[i].binary = i % 100 < cfg->binary_pct;
+		stations[i].rng = 0x9e3779b9U ^ (i * 2654435761U);
+		stations[i].boot_offset_ms = xorshift32(&stations[i].rng) %
+					     86400000;
+		// Spread the first sends over one period
+		stations[i].due_ns =
+			start_ns + (cfg->rate_hz ? (uint64_t)i * 1000000000ULL /
+							   cfg->rate_hz /
+							   cfg->stations :
+						   0);
+	}
+
+	per_thread = (cfg->stations + cfg->threads - 1) / cfg->threads;
+	for (i = 0; i < cfg->threads; ++i) {
+		threads[i].cfg = cfg;
+		threads[i].start_ns = start_ns;
+		threads[i].stations = stations + i * per_thread;
+		if (i * per_thread >= cfg->stations) {
+			threads[i].stations_len = 0;
+		} else if ((i + 1) * per_thread > cfg->stations) {
+			threads[i].stations_len = cfg->stations - i * per_thread;
+		} else {
+			threads[i].stations_len = per_thread;
+		}
+		pthread_create(&threads[i].thread, NULL, loadgen_main,
+			       &threads[i]);
+	}
+
+	stats->datagrams = 0;
+	stats->records = 0;
+	stats->send_errors = 0;
+	for (i = 0; i < cfg->threads; ++i) {
+		pthread_join(threads[i].thread, NULL);
+		stats->datagrams += threads[i].stats.datagrams;
+		stats->records += threads[i].stats.records;
+		stats->send_errors += threads[i].stats.send_errors;
+	}
+	ok = true;
+out:
+	for (i = 0; i < opened; ++i) {
+		close(stations[i].fd);
+	}
+	free(stations);
+	free(threads);
+	return ok;
+}
@@ -0,0 +1,48 @@
+#ifndef _PICOWEATHER_COLLECTOR_LOADGEN_H
+#define _PICOWEATHER_COLLECTOR_LOADGEN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Simulated stations sending to a collector over UDP. Every station has
+ * its own socket and sends one datagram per tick holding a UV index, UV
+ * dose and lux reading, as text lines or binary frames.
+ *
+ * With bench set, the UV dose value carries the sender's CLOCK_MONOTONIC
+ * time in microseconds (low 31 bits) so the receiver can measure
+ * end to end latency.
+ */
+
+struct pw_loadgen_cfg {
+	const char *host;
+	uint16_t port;
+	uint32_t stations;
+	uint32_t station_first;
+	uint32_t threads;
+	// Datagrams per second per station, 0 sends as fast as possible
+	uint32_t rate_hz;
+	uint32_t duration_ms;
+	// Share of stations that send the binary format
+	uint32_t binary_pct;
+	bool bench;
+};
+typedef struct pw_loadgen_cfg pw_loadgen_cfg_t;
+
+struct pw_loadgen_stats {
+	uint64_t datagrams;
+	uint64_t records;
+	uint64_t send_errors;
+};
+typedef struct pw_loadgen_stats pw_loadgen_stats_t;
+
+#define PW_LOADGEN_RECORDS_PER_DATAGRAM (3)
+
+/* Blocks for cfg->duration_ms */
+bool pw_loadgen_run(const pw_loadgen_cfg_t *cfg, pw_loadgen_stats_t *stats);
+
+inline static uint32_t pw_loadgen_bench_stamp(uint64_t now_ns)
+{
+	return (now_ns / 1000) & 0x7fffffff;
+}
+
+#endif /* _PICOWEATHER_COLLECTOR_LOADGEN_H */
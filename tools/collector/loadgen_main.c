@@ -0,0 +1,83 @@
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "loadgen.h"
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -a ADDR  Collector IPv4 address (default 127.0.0.1)\n"
+		"  -u PORT  Collector ingest port (default 7070)\n"
+		"  -n N     Simulated stations (default 500)\n"
+		"  -f ID    First station id (default 1)\n"
+		"  -R HZ    Datagrams/s per station, 0 = max (default 1)\n"
+		"  -d SEC   Duration in seconds (default 10)\n"
+		"  -T N     Sender threads (default 2)\n"
+		"  -B PCT   Percent of stations using the binary format (default 50)\n",
+		argv0);
+}
+
+int main(int argc, char **argv)
+{
+	pw_loadgen_cfg_t cfg = {
+		.host = "127.0.0.1",
+		.port = 7070,
+		.stations = 500,
+		.station_first = 1,
+		.threads = 2,
+		.rate_hz = 1,
+		.duration_ms = 10000,
+		.binary_pct = 50,
+		.bench = false,
+	};
+	pw_loadgen_stats_t stats;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "a:u:n:f:R:d:T:B:h")) != -1) {
+		switch (opt) {
+		case 'a':
+			cfg.host = optarg;
+			break;
+		case 'u':
+			cfg.port = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			cfg.stations = strtoul(optarg, NULL, 0);
+			break;
+		case 'f':
+			cfg.station_first = strtoul(optarg, NULL, 0);
+			break;
+		case 'R':
+			cfg.rate_hz = strtoul(optarg, NULL, 0);
+			break;
+		case 'd':
+			cfg.duration_ms = strtoul(optarg, NULL, 0) * 1000;
+			break;
+		case 'T':
+			cfg.threads = strtoul(optarg, NULL, 0);
+			break;
+		case 'B':
+			cfg.binary_pct = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+	if (cfg.stations == 0 || cfg.threads == 0) {
+		usage(argv[0]);
+		return 1;
+	}
+	if (!pw_loadgen_run(&cfg, &stats)) {
+		return 1;
+	}
+	printf("sent %llu datagrams, %llu records, %llu send errors\n",
+	       (unsigned long long)stats.datagrams,
+	       (unsigned long long)stats.records,
+	       (unsigned long long)stats.send_errors);
+	return 0;
+}
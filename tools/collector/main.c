@@ -0,0 +1,402 @@
+#include <ctype.h>
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ingest.h"
+#include "loadgen.h"
+#include "pool.h"
+#include "store.h"
+#include "wire.h"
+
+#define COLLECTOR_STATS_PERIOD_S (10)
+#define COLLECTOR_WORKERS_MAX (1024)
+#define BENCH_LATENCY_SAMPLES_MAX (1U << 24)
+
+struct collector_cfg {
+	const char *host;
+	uint16_t udp_port;
+	uint16_t query_port;
+	uint32_t workers;
+	uint32_t bufs;
+	uint32_t max_stations;
+	uint32_t ring_len;
+	uint32_t bench_s;
+	uint32_t bench_stations;
+	uint32_t bench_rate_hz;
+	uint32_t bench_threads;
+};
+
+struct bench_query {
+	pw_store_t *store;
+	uint32_t station_first;
+	uint32_t stations;
+	bool stopping;
+	uint32_t *latencies_us;
+	uint32_t latencies_len;
+	uint64_t queries;
+};
+
+static volatile sig_atomic_t collector_stop = 0;
+
+static void on_signal(int sig)
+{
+	(void)sig;
+	collector_stop = 1;
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -a ADDR         IPv4 address to bind (default 0.0.0.0)\n"
+		"  -u PORT         UDP ingest port (default 7070)\n"
+		"  -q PORT         UDP query port (default 7071)\n"
+		"  -t TTY=STATION  Read a station from a serial tty, repeatable\n"
+		"  -w N            Worker threads (default: online CPUs)\n"
+		"  -s N            Maximum number of stations (default 4096)\n"
+		"  -r N            Samples kept per station and channel (default 256)\n"
+		"  -b SECONDS      Benchmark against an in-process load generator\n"
+		"  -n N            Benchmark stations (default 500)\n"
+		"  -R HZ           Benchmark datagrams/s per station, 0 = max (default 0)\n"
+		"  -T N            Benchmark sender threads (default 2)\n",
+		argv0);
+}
+
+/* Takes a whole decimal, hex or octal number up to max, and nothing else */
+static bool parse_u32(const char *s, uint32_t max, uint32_t *out)
+{
+	unsigned long long value;
+	char *end;
+
+	// strtoull() would skip spaces and take a sign
+	if (!isdigit((unsigned char)s[0])) {
+		return false;
+	}
+	errno = 0;
+	value = strtoull(s, &end, 0);
+	if (errno != 0 || *end != '\0' || value > max) {
+		return false;
+	}
+	*out = value;
+	return true;
+}
+
+static bool parse_opt(int opt, const char *arg, uint32_t max, uint32_t *out)
+{
+	if (!parse_u32(arg, max, out)) {
+		fprintf(stderr, "Invalid -%c %s, expected a number up to %u.\n",
+			opt, arg, max);
+		return false;
+	}
+	return true;
+}
+
+static bool parse_tty(pw_ingest_t *ingest, char *arg)
+{
+	char *eq = strrchr(arg, '=');
+	uint32_t station;
+
+	if (eq == NULL) {
+		fprintf(stderr, "Expected TTY=STATION, got %s.\n", arg);
+		return false;
+	}
+	*eq = '\0';
+	// PW_STATION_NONE is reserved
+	if (!parse_u32(eq + 1, PW_STATION_NONE - 1, &station)) {
+		fprintf(stderr, "Invalid station %s for %s, expected up to %u.\n",
+			eq + 1, arg, PW_STATION_NONE - 1);
+		return false;
+	}
+	return pw_ingest_tty_add(ingest, arg, station);
+}
+
+static void stats_print(pw_ingest_t *ingest, pw_store_t *store,
+			pw_pool_t *pool)
+{
+	pw_parse_stats_t stats;
+	uint64_t rejected;
+
+	pw_pool_stats(pool, &stats, &rejected);
+	printf("stations %u datagrams %llu records %llu errors %llu rejected %llu\n",
+	       pw_store_station_count(store),
+	       (unsigned long long)__atomic_load_n(&ingest->datagrams,
+						   __ATOMIC_RELAXED),
+	       (unsigned long long)stats.records,
+	       (unsigned long long)stats.errors, (unsigned long long)rejected);
+	fflush(stdout);
+}
+
+/* Polls the latest UV dose of every simulated station. The load generator
+ * puts its send time there, so each new value gives one latency sample.
+ */
+static void *bench_query_main(void *arg)
+{
+	struct bench_query *bq = arg;
+	int32_t *last;
+	pw_sample_t sample;
+	uint32_t now_stamp;
+	uint32_t i;
+
+	last = calloc(bq->stations, sizeof(*last));
+	if (last == NULL) {
+		return NULL;
+	}
+	while (!__atomic_load_n(&bq->stopping, __ATOMIC_ACQUIRE)) {
+		for (i = 0; i < bq->stations; ++i) {
+			++bq->queries;
+			if (!pw_store_latest(bq->store, bq->station_first + i,
+					     PW_CHANNEL_UV_DOSE, &sample) ||
+			    sample.value == last[i]) {
+				continue;
+			}
+			last[i] = sample.value;
+			now_stamp = pw_loadgen_bench_stamp(pw_clock_ns());
+			if (bq->latencies_len < BENCH_LATENCY_SAMPLES_MAX) {
+				bq->latencies_us[bq->latencies_len++] =
+					(now_stamp - (uint32_t)sample.value) &
+					0x7fffffff;
+			}
+		}
+		// Leave the CPU to the workers between sweeps
+		sched_yield();
+	}
+	free(last);
+	return NULL;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static int bench_run(const struct collector_cfg *cfg, pw_ingest_t *ingest,
+		     pw_store_t *store, pw_pool_t *pool, uint16_t udp_port)
+{
+	pw_loadgen_cfg_t lg = {
+		.host = "127.0.0.1",
+		.port = udp_port,
+		.stations = cfg->bench_stations,
+		.station_first = 1,
+		.threads = cfg->bench_threads,
+		.rate_hz = cfg->bench_rate_hz,
+		.duration_ms = cfg->bench_s * 1000,
+		.binary_pct = 50,
+		.bench = true,
+	};
+	struct bench_query bq = {
+		.store = store,
+		.station_first = lg.station_first,
+		.stations = lg.stations,
+	};
+	pw_loadgen_stats_t lg_stats;
+	pw_parse_stats_t stats;
+	pthread_t query_thread;
+	uint64_t rejected;
+	uint64_t start_ns;
+	double elapsed_s;
+	uint32_t n;
+	bool ok;
+
+	bq.latencies_us = malloc(BENCH_LATENCY_SAMPLES_MAX * sizeof(uint32_t));
+	if (bq.latencies_us == NULL) {
+		return 1;
+	}
+	pthread_create(&query_thread, NULL, bench_query_main, &bq);
+	start_ns = pw_clock_ns();
+	ok = pw_loadgen_run(&lg, &lg_stats);
+	// Give the workers a moment to drain what is still queued
+	usleep(200000);
+	elapsed_s = (pw_clock_ns() - start_ns) / 1e9;
+	__atomic_store_n(&bq.stopping, true, __ATOMIC_RELEASE);
+	pthread_join(query_thread, NULL);
+	if (!ok) {
+		free(bq.latencies_us);
+		return 1;
+	}
+	pw_pool_stats(pool, &stats, &rejected);
+
+	printf("stations %u, %u sender threads, %u workers, %.2fs\n",
+	       lg.stations, lg.threads, cfg->workers, elapsed_s);
+	printf("sent %llu datagrams, received %llu, %llu send errors\n",
+	       (unsigned long long)lg_stats.datagrams,
+	       (unsigned long long)__atomic_load_n(&ingest->datagrams,
+						   __ATOMIC_RELAXED),
+	       (unsigned long long)lg_stats.send_errors);
+	printf("ingest: %llu records (%llu errors, %llu rejected), %.0f records/s\n",
+	       (unsigned long long)stats.records,
+	       (unsigned long long)stats.errors, (unsigned long long)rejected,
+	       stats.records / elapsed_s);
+	n = bq.latencies_len;
+	if (n == 0) {
+		printf("ingest-to-query latency: no samples\n");
+	} else {
+		qsort(bq.latencies_us, n, sizeof(uint32_t), cmp_u32);
+		printf("ingest-to-query latency over %u samples (%llu queries): p50 %uus p99 %uus max %uus\n",
+		       n, (unsigned long long)bq.queries,
+		       bq.latencies_us[n / 2], bq.latencies_us[n * 99ULL / 100],
+		       bq.latencies_us[n - 1]);
+	}
+	free(bq.latencies_us);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct collector_cfg cfg = {
+		.host = "0.0.0.0",
+		.udp_port = 7070,
+		.query_port = 7071,
+		.workers = sysconf(_SC_NPROCESSORS_ONLN),
+		.bufs = 4096,
+		.max_stations = 4096,
+		.ring_len = 256,
+		.bench_stations = 500,
+		.bench_rate_hz = 0,
+		.bench_threads = 2,
+	};
+	pw_store_t store;
+	pw_pool_t pool;
+	pw_ingest_t ingest;
+	char *ttys[PW_INGEST_TTYS_MAX];
+	uint32_t ttys_len = 0;
+	uint16_t udp_port;
+	uint16_t query_port;
+	uint32_t value;
+	uint32_t i;
+	bool ok = true;
+	int ret = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "a:u:q:t:w:s:r:b:n:R:T:h")) != -1) {
+		switch (opt) {
+		case 'a':
+			cfg.host = optarg;
+			break;
+		case 'u':
+			ok = parse_opt(opt, optarg, UINT16_MAX, &value);
+			cfg.udp_port = value;
+			break;
+		case 'q':
+			ok = parse_opt(opt, optarg, UINT16_MAX, &value);
+			cfg.query_port = value;
+			break;
+		case 't':
+			if (ttys_len == PW_INGEST_TTYS_MAX) {
+				fprintf(stderr, "Too many ttys.\n");
+				return 1;
+			}
+			ttys[ttys_len++] = optarg;
+			break;
+		case 'w':
+			ok = parse_opt(opt, optarg, COLLECTOR_WORKERS_MAX,
+				       &cfg.workers);
+			break;
+		case 's':
+			ok = parse_opt(opt, optarg, UINT32_MAX,
+				       &cfg.max_stations);
+			break;
+		case 'r':
+			ok = parse_opt(opt, optarg, UINT32_MAX, &cfg.ring_len);
+			break;
+		case 'b':
+			// Kept in milliseconds by the load generator
+			ok = parse_opt(opt, optarg, UINT32_MAX / 1000,
+				       &cfg.bench_s);
+			break;
+		case 'n':
+			ok = parse_opt(opt, optarg, UINT32_MAX,
+				       &cfg.bench_stations);
+			break;
+		case 'R':
+			ok = parse_opt(opt, optarg, UINT32_MAX,
+				       &cfg.bench_rate_hz);
+			break;
+		case 'T':
+			ok = parse_opt(opt, optarg, UINT32_MAX,
+				       &cfg.bench_threads);
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+		if (!ok) {
+			return 1;
+		}
+	}
+	if (cfg.workers == 0 || cfg.bench_threads == 0 || cfg.ring_len == 0 ||
+	    cfg.max_stations == 0) {
+		usage(argv[0]);
+		return 1;
+	}
+	if (cfg.bench_s != 0) {
+		// The benchmark runs on loopback with ephemeral ports
+		cfg.host = "127.0.0.1";
+		cfg.udp_port = 0;
+		cfg.query_port = 0;
+		if (cfg.bench_stations > cfg.max_stations) {
+			cfg.max_stations = cfg.bench_stations;
+		}
+	}
+
+	if (!pw_store_init(&store, cfg.max_stations, cfg.ring_len)) {
+		fprintf(stderr, "Failed to allocate the store.\n");
+		return 1;
+	}
+	if (!pw_pool_init(&pool, &store, cfg.workers, cfg.bufs)) {
+		fprintf(stderr, "Failed to start the worker pool.\n");
+		pw_store_destroy(&store);
+		return 1;
+	}
+	pw_ingest_init(&ingest, &pool, &store);
+	udp_port = cfg.udp_port;
+	query_port = cfg.query_port;
+	if (!pw_ingest_udp_open(&ingest, cfg.host, &udp_port) ||
+	    !pw_ingest_query_open(&ingest, cfg.host, &query_port)) {
+		ret = 1;
+		goto out;
+	}
+	for (i = 0; i < ttys_len; ++i) {
+		if (!parse_tty(&ingest, ttys[i])) {
+			ret = 1;
+			goto out;
+		}
+	}
+	pw_ingest_start(&ingest);
+
+	if (cfg.bench_s != 0) {
+		ret = bench_run(&cfg, &ingest, &store, &pool, udp_port);
+	} else {
+		printf("Listening on %s, ingest port %u, query port %u, %u ttys, %u workers.\n",
+		       cfg.host, udp_port, query_port, ingest.ttys_len,
+		       cfg.workers);
+		fflush(stdout);
+		signal(SIGINT, on_signal);
+		signal(SIGTERM, on_signal);
+		while (!collector_stop) {
+			for (i = 0; i < COLLECTOR_STATS_PERIOD_S &&
+				    !collector_stop;
+			     ++i) {
+				sleep(1);
+			}
+			stats_print(&ingest, &store, &pool);
+		}
+	}
+out:
+	pw_ingest_stop(&ingest);
+	pw_pool_stop(&pool);
+	pw_pool_destroy(&pool);
+	pw_store_destroy(&store);
+	return ret;
+}
@@ -0,0 +1,300 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "parse.h"
+#include "wire.h"
+
+struct pw_tok {
+	const char *p;
+	const char *end;
+};
+typedef struct pw_tok pw_tok_t;
+
+struct text_label {
+	const char *label;
+	size_t len;
+	pw_channel_t channel;
+	// Number of decimals kept in the fixed point value
+	uint32_t scale;
+};
+
+#define TEXT_LABEL(s, ch, sc) { s, sizeof(s) - 1, ch, sc }
+
+/* Labels printed by the firmware, see pw_sensors.c */
+static const struct text_label TEXT_LABELS[] = {
+	TEXT_LABEL("UV Index", PW_CHANNEL_UV_INDEX, 2),
+	TEXT_LABEL("UV Dose", PW_CHANNEL_UV_DOSE, 0),
+	TEXT_LABEL("Lux", PW_CHANNEL_LUX, 2),
+};
+
+inline static bool tok_eat(pw_tok_t *tok, char c)
+{
+	if (tok->p < tok->end && *tok->p == c) {
+		++tok->p;
+		return true;
+	}
+	return false;
+}
+
+inline static void tok_skip_spaces(pw_tok_t *tok)
+{
+	while (tok->p < tok->end && *tok->p == ' ') {
+		++tok->p;
+	}
+}
+
+static bool tok_u32(pw_tok_t *tok, uint32_t *out)
+{
+	const char *start = tok->p;
+	uint64_t v = 0;
+
+	while (tok->p < tok->end && *tok->p >= '0' && *tok->p <= '9') {
+		v = v * 10 + (uint64_t)(*tok->p - '0');
+		if (v > UINT32_MAX) {
+			return false;
+		}
+		++tok->p;
+	}
+	*out = v;
+	return tok->p != start;
+}
+
+/* Parses [-]digits[.digits] into a value scaled by 10^scale. Extra
+ * decimals are truncated.
+ */
+static bool tok_fixed(pw_tok_t *tok, uint32_t scale, int32_t *out)
+{
+	bool negative;
+	uint32_t whole;
+	uint32_t digits = 0;
+	int64_t v;
+
+	negative = tok_eat(tok, '-');
+	if (!tok_u32(tok, &whole)) {
+		return false;
+	}
+	v = whole;
+	if (tok_eat(tok, '.')) {
+		while (tok->p < tok->end && *tok->p >= '0' && *tok->p <= '9') {
+			if (digits < scale) {
+				v = v * 10 + (*tok->p - '0');
+				++digits;
+			}
+			++tok->p;
+		}
+	}
+	for (; digits < scale; ++digits) {
+		v *= 10;
+	}
+	if (v > INT32_MAX) {
+		return false;
+	}
+	*out = negative ? -(int32_t)v : (int32_t)v;
+	return true;
+}
+
+static const struct text_label *tok_label(pw_tok_t *tok)
+{
+	const char *colon;
+	size_t len;
+	size_t i;
+
+	colon = memchr(tok->p, ':', tok->end - tok->p);
+	if (colon == NULL) {
+		return NULL;
+	}
+	len = colon - tok->p;
+	for (i = 0; i < sizeof(TEXT_LABELS) / sizeof(TEXT_LABELS[0]); ++i) {
+		if (TEXT_LABELS[i].len == len &&
+		    memcmp(TEXT_LABELS[i].label, tok->p, len) == 0) {
+			tok->p = colon + 1;
+			return &TEXT_LABELS[i];
+		}
+	}
+	return NULL;
+}
+
+/* Returns false only for malformed readings. Lines that aren't readings
+ * at all are skipped silently.
+ */
+static bool parse_line(pw_tok_t *tok, uint32_t station, pw_record_t *record,
+		       bool *found)
+{
+	const struct text_label *label;
+
+	*found = false;
+	if (tok_eat(tok, '@')) {
+		if (!tok_u32(tok, &station) || station == PW_STATION_NONE) {
+			return false;
+		}
+		tok_skip_spaces(tok);
+	}
+	if (!tok_eat(tok, '[')) {
+		return true;
+	}
+	if (!tok_u32(tok, &record->timestamp_ms) || !tok_eat(tok, 'm') ||
+	    !tok_eat(tok, 's') || !tok_eat(tok, ']')) {
+		return false;
+	}
+	tok_skip_spaces(tok);
+	label = tok_label(tok);
+	if (label == NULL) {
+		return true;
+	}
+	// A reading without a station to credit it to
+	if (station == PW_STATION_NONE) {
+		return false;
+	}
+	tok_skip_spaces(tok);
+	if (!tok_fixed(tok, label->scale, &record->value)) {
+		return false;
+	}
+	record->channel = label->channel;
+	record->station = station;
+	*found = true;
+	return true;
+}
+
+/* Parses the line from p up to eol, which excludes the '\n' */
+static void parse_text_line(const char *p, const char *eol, uint32_t station,
+			    pw_record_fn emit, void *ctx,
+			    pw_parse_stats_t *stats)
+{
+	pw_tok_t tok;
+	pw_record_t record;
+	bool found;
+
+	tok.p = p;
+	tok.end = eol;
+	// The SDK's stdio turns "\n" into "\r\n"
+	if (tok.end > tok.p && tok.end[-1] == '\r') {
+		--tok.end;
+	}
+	if (!parse_line(&tok, station, &record, &found)) {
+		++stats->errors;
+	} else if (found) {
+		++stats->records;
+		emit(ctx, &record);
+	}
+}
+
+size_t pw_parse_text(const char *buf, size_t len, uint32_t station,
+		     pw_record_fn emit, void *ctx, pw_parse_stats_t *stats)
+{
+	const char *p = buf;
+	const char *end = buf + len;
+	const char *eol;
+
+	while (p < end) {
+		eol = memchr(p, '\n', end - p);
+		if (eol == NULL) {
+			break;
+		}
+		parse_text_line(p, eol, station, emit, ctx, stats);
+		p = eol + 1;
+	}
+	return p - buf;
+}
+
+size_t pw_parse_binary(const uint8_t *buf, size_t len, pw_record_fn emit,
+		       void *ctx, pw_parse_stats_t *stats)
+{
+	size_t off = 0;
+	const uint8_t *next;
+	pw_record_t record;
+
+	while (len - off >= PW_WIRE_FRAME_LEN) {
+		if (pw_wire_decode(buf + off, &record)) {
+			++stats->records;
+			emit(ctx, &record);
+			off += PW_WIRE_FRAME_LEN;
+			continue;
+		}
+		++stats->errors;
+		next = memchr(buf + off + 1, PW_WIRE_MAGIC0, len - off - 1);
+		// Too short for a frame, so the rest belongs to this error
+		if (next == NULL || len - (next - buf) < PW_WIRE_FRAME_LEN) {
+			return len;
+		}
+		off = next - buf;
+	}
+	return off;
+}
+
+size_t pw_parse(const char *buf, size_t len, uint32_t station,
+		pw_record_fn emit, void *ctx, pw_parse_stats_t *stats)
+{
+	if (pw_wire_is_binary(buf, len)) {
+		return pw_parse_binary((const uint8_t *)buf, len, emit, ctx,
+				       stats);
+	}
+	return pw_parse_text(buf, len, station, emit, ctx, stats);
+}
+
+/* Whether p starts a frame magic. At the end of the buffer the bytes
+ * that are there only have to match the start of it.
+ */
+inline static bool stream_is_magic(const char *p, const char *end)
+{
+	static const char magic[] = { PW_WIRE_MAGIC0, PW_WIRE_MAGIC1,
+				      PW_WIRE_VERSION };
+	size_t len = end - p < 3 ? (size_t)(end - p) : 3;
+
+	return len != 0 && memcmp(p, magic, len) == 0;
+}
+
+/* The first '\n' or magic at or after p, or end if there is neither */
+static const char *stream_next(const char *p, const char *end)
+{
+	for (; p < end; ++p) {
+		if (*p == '\n' ||
+		    (*p == PW_WIRE_MAGIC0 && stream_is_magic(p, end))) {
+			break;
+		}
+	}
+	return p;
+}
+
+size_t pw_parse_stream(const char *buf, size_t len, uint32_t station,
+		       pw_record_fn emit, void *ctx, pw_parse_stats_t *stats)
+{
+	const char *p = buf;
+	const char *end = buf + len;
+	const char *next;
+	pw_record_t record;
+
+	while (p < end) {
+		if (stream_is_magic(p, end)) {
+			if (end - p < PW_WIRE_FRAME_LEN) {
+				break;
+			}
+			if (pw_wire_decode((const uint8_t *)p, &record)) {
+				++stats->records;
+				emit(ctx, &record);
+				p += PW_WIRE_FRAME_LEN;
+				continue;
+			}
+			// A byte was lost or flipped, resync past this magic
+			++stats->errors;
+			++p;
+			continue;
+		}
+		next = stream_next(p, end);
+		if (next == end || (*next != '\n' && end - next < 3)) {
+			// A partial line, or one that may end in a partial magic
+			break;
+		}
+		if (*next == '\n') {
+			parse_text_line(p, next, station, emit, ctx, stats);
+			p = next + 1;
+			continue;
+		}
+		/* Text cut short by a frame is skipped. It is usually the rest
+		 * of a frame that failed above.
+		 */
+		p = next;
+	}
+	return p - buf;
+}
@@ -0,0 +1,58 @@
+#ifndef _PICOWEATHER_COLLECTOR_PARSE_H
+#define _PICOWEATHER_COLLECTOR_PARSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "wire.h"
+
+/* Parsers for the two station formats. Both work in place on the receive
+ * buffer; tokens are slices of it and nothing is copied.
+ *
+ * Text is what pw_log() prints, one reading per line:
+ *   [1234ms] UV Index: 3.21
+ * A line may be prefixed with "@<station> " to name the station, which is
+ * how stations sharing one UDP socket are told apart. Without it the line
+ * belongs to the station passed in; if that is PW_STATION_NONE a reading
+ * is an error. Lines with an unknown label (e.g. health reports) are
+ * skipped.
+ *
+ * Binary is a sequence of frames as described in wire.h.
+ */
+
+typedef void (*pw_record_fn)(void *ctx, const pw_record_t *record);
+
+struct pw_parse_stats {
+	uint64_t records;
+	uint64_t errors;
+};
+typedef struct pw_parse_stats pw_parse_stats_t;
+
+/* Parses every complete line and returns the number of bytes consumed,
+ * so the caller can keep a trailing partial line for the next read.
+ */
+size_t pw_parse_text(const char *buf, size_t len, uint32_t station,
+		     pw_record_fn emit, void *ctx, pw_parse_stats_t *stats);
+
+/* Parses every complete frame and returns the number of bytes consumed.
+ * Corrupt frames are skipped by scanning for the next magic. A corrupt
+ * frame counts as one error together with whatever follows it up to the
+ * next frame, so only a partial frame after a good one is left over.
+ */
+size_t pw_parse_binary(const uint8_t *buf, size_t len, pw_record_fn emit,
+		       void *ctx, pw_parse_stats_t *stats);
+
+/* Parses a byte stream mixing lines and frames, as read from a serial
+ * port. Returns the number of bytes consumed; the rest is a partial line
+ * or frame to retry once more bytes arrived. A frame that fails to decode
+ * counts as an error, and its remaining bytes are skipped up to the next
+ * magic or line.
+ */
+size_t pw_parse_stream(const char *buf, size_t len, uint32_t station,
+		       pw_record_fn emit, void *ctx, pw_parse_stats_t *stats);
+
+/* Picks the format of a datagram from its first bytes */
+size_t pw_parse(const char *buf, size_t len, uint32_t station,
+		pw_record_fn emit, void *ctx, pw_parse_stats_t *stats);
+
+#endif /* _PICOWEATHER_COLLECTOR_PARSE_H */
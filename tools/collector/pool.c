@@ -0,0 +1,231 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "parse.h"
+#include "pool.h"
+#include "store.h"
+
+uint64_t pw_clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void pw_stream_init(pw_stream_t *stream)
+{
+	stream->len = 0;
+}
+
+static void worker_emit(void *ctx, const pw_record_t *record)
+{
+	pw_worker_t *worker = ctx;
+	pw_pool_t *pool = worker->pool;
+	pw_station_t *station = worker->station_last;
+
+	// Buffers usually hold readings from a single station
+	if (station == NULL || station->id != record->station) {
+		station = pw_store_station(pool->store, record->station, true);
+		if (station == NULL) {
+			__atomic_fetch_add(&pool->rejected, 1,
+					   __ATOMIC_RELAXED);
+			return;
+		}
+		worker->station_last = station;
+	}
+	if (!pw_store_append(pool->store, station, record, worker->now_ns)) {
+		__atomic_fetch_add(&pool->rejected, 1, __ATOMIC_RELAXED);
+	}
+}
+
+/* Parses a stream buffer behind what the stream left over, and keeps
+ * what is left of this one for the next
+ */
+static void worker_stream(pw_worker_t *worker, const pw_buf_t *buf,
+			  pw_parse_stats_t *stats)
+{
+	pw_stream_t *stream = buf->stream;
+	size_t consumed;
+
+	memcpy(stream->data + stream->len, buf->data, buf->len);
+	stream->len += buf->len;
+	consumed = pw_parse_stream(stream->data, stream->len, buf->station,
+				   worker_emit, worker, stats);
+	stream->len -= consumed;
+	if (stream->len >= PW_BUF_SIZE) {
+		// A line longer than a buffer is garbage, drop it
+		++stats->errors;
+		stream->len = 0;
+	}
+	memmove(stream->data, stream->data + consumed, stream->len);
+}
+
+static void *worker_main(void *arg)
+{
+	pw_worker_t *worker = arg;
+	pw_pool_t *pool = worker->pool;
+	pw_buf_t *batch;
+	pw_buf_t *buf;
+	pw_parse_stats_t stats;
+
+	while (true) {
+		pthread_mutex_lock(&worker->lock);
+		while (worker->head == NULL && !pool->stopping) {
+			pthread_cond_wait(&worker->cond, &worker->lock);
+		}
+		batch = worker->head;
+		worker->head = NULL;
+		worker->tail = NULL;
+		pthread_mutex_unlock(&worker->lock);
+		if (batch == NULL) {
+			break;
+		}
+
+		stats.records = 0;
+		stats.errors = 0;
+		while (batch != NULL) {
+			buf = batch;
+			batch = buf->next;
+			worker->now_ns = pw_clock_ns();
+			if (buf->stream != NULL) {
+				worker_stream(worker, buf, &stats);
+			} else if (pw_parse(buf->data, buf->len, buf->station,
+					    worker_emit, worker,
+					    &stats) != buf->len) {
+				// A datagram holds whole lines and frames, a
+				// tail is junk
+				++stats.errors;
+			}
+			pw_pool_buf_put(pool, buf);
+		}
+		pw_pool_stats_add(pool, &stats);
+	}
+	return NULL;
+}
+
+bool pw_pool_init(pw_pool_t *pool, pw_store_t *store, uint32_t workers,
+		  uint32_t bufs)
+{
+	uint32_t i;
+
+	pool->store = store;
+	pool->workers_len = workers;
+	pool->stopping = false;
+	pool->records = 0;
+	pool->errors = 0;
+	pool->rejected = 0;
+	pool->workers = calloc(workers, sizeof(*pool->workers));
+	pool->bufs = calloc(bufs, sizeof(*pool->bufs));
+	if (pool->workers == NULL || pool->bufs == NULL) {
+		free(pool->workers);
+		free(pool->bufs);
+		return false;
+	}
+	pool->free_list = NULL;
+	for (i = 0; i < bufs; ++i) {
+		pool->bufs[i].next = pool->free_list;
+		pool->free_list = &pool->bufs[i];
+	}
+	pthread_mutex_init(&pool->free_lock, NULL);
+	pthread_cond_init(&pool->free_cond, NULL);
+
+	for (i = 0; i < workers; ++i) {
+		pool->workers[i].pool = pool;
+		pthread_mutex_init(&pool->workers[i].lock, NULL);
+		pthread_cond_init(&pool->workers[i].cond, NULL);
+		pthread_create(&pool->workers[i].thread, NULL, worker_main,
+			       &pool->workers[i]);
+	}
+	return true;
+}
+
+void pw_pool_stop(pw_pool_t *pool)
+{
+	uint32_t i;
+
+	pthread_mutex_lock(&pool->free_lock);
+	pool->stopping = true;
+	pthread_cond_broadcast(&pool->free_cond);
+	pthread_mutex_unlock(&pool->free_lock);
+
+	for (i = 0; i < pool->workers_len; ++i) {
+		pthread_mutex_lock(&pool->workers[i].lock);
+		pthread_cond_signal(&pool->workers[i].cond);
+		pthread_mutex_unlock(&pool->workers[i].lock);
+		pthread_join(pool->workers[i].thread, NULL);
+	}
+}
+
+void pw_pool_destroy(pw_pool_t *pool)
+{
+	uint32_t i;
+
+	for (i = 0; i < pool->workers_len; ++i) {
+		pthread_mutex_destroy(&pool->workers[i].lock);
+		pthread_cond_destroy(&pool->workers[i].cond);
+	}
+	pthread_mutex_destroy(&pool->free_lock);
+	pthread_cond_destroy(&pool->free_cond);
+	free(pool->workers);
+	free(pool->bufs);
+}
+
+pw_buf_t *pw_pool_buf_get(pw_pool_t *pool)
+{
+	pw_buf_t *buf;
+
+	pthread_mutex_lock(&pool->free_lock);
+	while (pool->free_list == NULL && !pool->stopping) {
+		pthread_cond_wait(&pool->free_cond, &pool->free_lock);
+	}
+	buf = pool->stopping ? NULL : pool->free_list;
+	if (buf != NULL) {
+		pool->free_list = buf->next;
+	}
+	pthread_mutex_unlock(&pool->free_lock);
+	return buf;
+}
+
+void pw_pool_buf_put(pw_pool_t *pool, pw_buf_t *buf)
+{
+	pthread_mutex_lock(&pool->free_lock);
+	buf->next = pool->free_list;
+	pool->free_list = buf;
+	pthread_cond_signal(&pool->free_cond);
+	pthread_mutex_unlock(&pool->free_lock);
+}
+
+void pw_pool_submit(pw_pool_t *pool, pw_buf_t *buf, uint32_t shard)
+{
+	pw_worker_t *worker = &pool->workers[shard % pool->workers_len];
+
+	buf->next = NULL;
+	pthread_mutex_lock(&worker->lock);
+	if (worker->tail == NULL) {
+		worker->head = buf;
+		pthread_cond_signal(&worker->cond);
+	} else {
+		worker->tail->next = buf;
+	}
+	worker->tail = buf;
+	pthread_mutex_unlock(&worker->lock);
+}
+
+void pw_pool_stats(pw_pool_t *pool, pw_parse_stats_t *out,
+		   uint64_t *rejected)
+{
+	out->records = __atomic_load_n(&pool->records, __ATOMIC_RELAXED);
+	out->errors = __atomic_load_n(&pool->errors, __ATOMIC_RELAXED);
+	*rejected = __atomic_load_n(&pool->rejected, __ATOMIC_RELAXED);
+}
+
+void pw_pool_stats_add(pw_pool_t *pool, const pw_parse_stats_t *stats)
+{
+	__atomic_fetch_add(&pool->records, stats->records, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&pool->errors, stats->errors, __ATOMIC_RELAXED);
+}
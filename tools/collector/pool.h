@@ -0,0 +1,97 @@
+#ifndef _PICOWEATHER_COLLECTOR_POOL_H
+#define _PICOWEATHER_COLLECTOR_POOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "parse.h"
+#include "store.h"
+
+/* Worker pool that parses receive buffers and appends the records to the
+ * store.
+ *
+ * Receivers take a buffer from the pool, read straight into it and submit
+ * it with a shard key. Buffers with the same key always go to the same
+ * worker, so readings from one source are stored in arrival order. The
+ * worker parses the buffer in place and returns it to the free list.
+ *
+ * A buffer from a serial stream may end in the middle of a line or frame.
+ * Its worker parses it behind what the stream's previous buffer left
+ * over, which is why a stream must always use the same shard key.
+ */
+
+#define PW_BUF_SIZE (2048)
+
+/* What a stream's buffers left over for its next one. Only touched by the
+ * worker its shard key maps to.
+ */
+struct pw_stream {
+	// A partial line up to a buffer, followed by the next buffer
+	char data[2 * PW_BUF_SIZE];
+	size_t len;
+};
+typedef struct pw_stream pw_stream_t;
+
+struct pw_buf {
+	struct pw_buf *next;
+	uint32_t len;
+	// Station for text lines without an "@<station>" prefix, or
+	// PW_STATION_NONE if they must have one
+	uint32_t station;
+	// The stream this was read from, NULL for a datagram
+	pw_stream_t *stream;
+	// One spare byte so a datagram can always be terminated with '\n'
+	char data[PW_BUF_SIZE + 1];
+};
+typedef struct pw_buf pw_buf_t;
+
+struct pw_worker {
+	struct pw_pool *pool;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pw_buf_t *head;
+	pw_buf_t *tail;
+	// Only used by the worker thread
+	pw_station_t *station_last;
+	uint64_t now_ns;
+};
+typedef struct pw_worker pw_worker_t;
+
+struct pw_pool {
+	pw_store_t *store;
+	pw_worker_t *workers;
+	uint32_t workers_len;
+	pw_buf_t *bufs;
+	pw_buf_t *free_list;
+	pthread_mutex_t free_lock;
+	pthread_cond_t free_cond;
+	bool stopping;
+	uint64_t records;
+	uint64_t errors;
+	uint64_t rejected;
+};
+typedef struct pw_pool pw_pool_t;
+
+bool pw_pool_init(pw_pool_t *pool, pw_store_t *store, uint32_t workers,
+		  uint32_t bufs);
+/* Waits for queued buffers to be parsed, then joins the workers */
+void pw_pool_stop(pw_pool_t *pool);
+void pw_pool_destroy(pw_pool_t *pool);
+
+/* Blocks until a buffer is free. Returns NULL once the pool is stopping. */
+pw_buf_t *pw_pool_buf_get(pw_pool_t *pool);
+void pw_pool_buf_put(pw_pool_t *pool, pw_buf_t *buf);
+void pw_pool_submit(pw_pool_t *pool, pw_buf_t *buf, uint32_t shard);
+
+void pw_stream_init(pw_stream_t *stream);
+
+/* Counters summed over all workers and receivers */
+void pw_pool_stats(pw_pool_t *pool, pw_parse_stats_t *out,
+		   uint64_t *rejected);
+void pw_pool_stats_add(pw_pool_t *pool, const pw_parse_stats_t *stats);
+
+uint64_t pw_clock_ns(void);
+
+#endif /* _PICOWEATHER_COLLECTOR_POOL_H */
@@ -0,0 +1,280 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "store.h"
+
+static const char *const CHANNEL_NAMES[] = {
+	[PW_CHANNEL_UV_INDEX] = "uv_index",
+	[PW_CHANNEL_UV_DOSE] = "uv_dose",
+	[PW_CHANNEL_LUX] = "lux",
+	[PW_CHANNEL_TEMPERATURE] = "temperature",
+	[PW_CHANNEL_HUMIDITY] = "humidity",
+	[PW_CHANNEL_PRESSURE] = "pressure",
+	[PW_CHANNEL_DEW_POINT] = "dew_point",
+	[PW_CHANNEL_HEAT_INDEX] = "heat_index",
+	[PW_CHANNEL_ABS_HUMIDITY] = "abs_humidity",
+	[PW_CHANNEL_CO2EQ] = "co2eq",
+	[PW_CHANNEL_TVOC] = "tvoc",
+};
+_Static_assert(sizeof(CHANNEL_NAMES) / sizeof(CHANNEL_NAMES[0]) ==
+		       PW_CHANNEL_COUNT,
+	       "Every channel needs a name");
+
+inline static uint32_t pow2_ceil(uint32_t v)
+{
+	uint32_t p = 1;
+
+	while (p < v) {
+		p <<= 1;
+	}
+	return p;
+}
+
+/* Fibonacci hashing spreads sequential station ids across the table */
+inline static uint32_t station_hash(uint32_t id)
+{
+	return id * 2654435769U;
+}
+
+bool pw_store_init(pw_store_t *store, uint32_t max_stations,
+		   uint32_t ring_len)
+{
+	// Keep the table at most half full so probes stay short
+	store->slots_len = pow2_ceil(max_stations * 2);
+	store->ring_len = pow2_ceil(ring_len);
+	store->stations = 0;
+	store->slots = calloc(store->slots_len, sizeof(*store->slots));
+	if (store->slots == NULL) {
+		return false;
+	}
+	pthread_mutex_init(&store->insert_lock, NULL);
+	return true;
+}
+
+void pw_store_destroy(pw_store_t *store)
+{
+	uint32_t i;
+	uint32_t ch;
+	pw_station_t *station;
+
+	for (i = 0; i < store->slots_len; ++i) {
+		station = store->slots[i];
+		if (station == NULL) {
+			continue;
+		}
+		for (ch = 0; ch < PW_CHANNEL_COUNT; ++ch) {
+			if (station->series[ch] != NULL) {
+				free(station->series[ch]->timestamps_ms);
+				free(station->series[ch]->values);
+				free(station->series[ch]);
+			}
+		}
+		pthread_mutex_destroy(&station->lock);
+		free(station);
+	}
+	free(store->slots);
+	pthread_mutex_destroy(&store->insert_lock);
+}
+
+static pw_station_t *station_find(pw_store_t *store, uint32_t id,
+				  uint32_t *slot_out)
+{
+	uint32_t mask = store->slots_len - 1;
+	uint32_t slot = station_hash(id) & mask;
+	pw_station_t *station;
+
+	while (true) {
+		station = __atomic_load_n(&store->slots[slot],
+					  __ATOMIC_ACQUIRE);
+		if (station == NULL || station->id == id) {
+			*slot_out = slot;
+			return station;
+		}
+		slot = (slot + 1) & mask;
+	}
+}
+
+pw_station_t *pw_store_station(pw_store_t *store, uint32_t id, bool create)
+{
+	pw_station_t *station;
+	uint32_t slot;
+
+	station = station_find(store, id, &slot);
+	if (station != NULL || !create) {
+		return station;
+	}
+
+	pthread_mutex_lock(&store->insert_lock);
+	// Someone else may have inserted it since the lookup
+	station = station_find(store, id, &slot);
+	if (station != NULL) {
+		goto out;
+	}
+	if (store->stations + 1 > store->slots_len / 2) {
+		goto out;
+	}
+	station = calloc(1, sizeof(*station));
+	if (station == NULL) {
+		goto out;
+	}
+	station->id = id;
+	pthread_mutex_init(&station->lock, NULL);
+	__atomic_store_n(&store->slots[slot], station, __ATOMIC_RELEASE);
+	__atomic_store_n(&store->stations, store->stations + 1,
+			 __ATOMIC_RELAXED);
+out:
+	pthread_mutex_unlock(&store->insert_lock);
+	return station;
+}
+
+static pw_series_t *series_alloc(uint32_t ring_len)
+{
+	pw_series_t *series;
+
+	series = calloc(1, sizeof(*series));
+	if (series == NULL) {
+		return NULL;
+	}
+	series->timestamps_ms = malloc(ring_len * sizeof(uint32_t));
+	series->values = malloc(ring_len * sizeof(int32_t));
+	if (series->timestamps_ms == NULL || series->values == NULL) {
+		free(series->timestamps_ms);
+		free(series->values);
+		free(series);
+		return NULL;
+	}
+	return series;
+}
+
+bool pw_store_append(pw_store_t *store, pw_station_t *station,
+		     const pw_record_t *record, uint64_t ingest_ns)
+{
+	pw_series_t *series;
+	bool ok = true;
+
+	pthread_mutex_lock(&station->lock);
+	series = station->series[record->channel];
+	if (series == NULL) {
+		series = series_alloc(store->ring_len);
+		if (series == NULL) {
+			ok = false;
+			goto out;
+		}
+		station->series[record->channel] = series;
+	}
+	series->timestamps_ms[series->head] = record->timestamp_ms;
+	series->values[series->head] = record->value;
+	series->head = (series->head + 1) & (store->ring_len - 1);
+	if (series->count < store->ring_len) {
+		++series->count;
+	}
+	series->ingest_ns_last = ingest_ns;
+out:
+	pthread_mutex_unlock(&station->lock);
+	return ok;
+}
+
+inline static uint32_t series_newest(const pw_store_t *store,
+				     const pw_series_t *series)
+{
+	return (series->head - 1) & (store->ring_len - 1);
+}
+
+bool pw_store_latest(pw_store_t *store, uint32_t station_id,
+		     pw_channel_t channel, pw_sample_t *out)
+{
+	pw_station_t *station;
+	pw_series_t *series;
+	uint32_t i;
+	bool found = false;
+
+	station = pw_store_station(store, station_id, false);
+	if (station == NULL) {
+		return false;
+	}
+	pthread_mutex_lock(&station->lock);
+	series = station->series[channel];
+	if (series != NULL && series->count != 0) {
+		i = series_newest(store, series);
+		out->timestamp_ms = series->timestamps_ms[i];
+		out->value = series->values[i];
+		out->ingest_ns = series->ingest_ns_last;
+		found = true;
+	}
+	pthread_mutex_unlock(&station->lock);
+	return found;
+}
+
+bool pw_store_window(pw_store_t *store, uint32_t station_id,
+		     pw_channel_t channel, uint32_t window_ms,
+		     pw_aggregate_t *out)
+{
+	pw_station_t *station;
+	pw_series_t *series;
+	uint32_t mask = store->ring_len - 1;
+	uint32_t newest_ms;
+	uint32_t i;
+	uint32_t n;
+	int32_t v;
+
+	station = pw_store_station(store, station_id, false);
+	if (station == NULL) {
+		return false;
+	}
+	out->count = 0;
+	out->min = INT32_MAX;
+	out->max = INT32_MIN;
+	out->sum = 0;
+
+	pthread_mutex_lock(&station->lock);
+	series = station->series[channel];
+	if (series == NULL || series->count == 0) {
+		pthread_mutex_unlock(&station->lock);
+		return false;
+	}
+	i = series_newest(store, series);
+	newest_ms = series->timestamps_ms[i];
+	// Walk back from the newest sample. Wrapping math keeps this correct
+	// across the station's 49 day millisecond rollover.
+	for (n = 0; n < series->count; ++n, i = (i - 1) & mask) {
+		if (newest_ms - series->timestamps_ms[i] > window_ms) {
+			break;
+		}
+		v = series->values[i];
+		out->min = v < out->min ? v : out->min;
+		out->max = v > out->max ? v : out->max;
+		out->sum += v;
+	}
+	out->count = n;
+	pthread_mutex_unlock(&station->lock);
+	return true;
+}
+
+uint32_t pw_store_station_count(pw_store_t *store)
+{
+	return __atomic_load_n(&store->stations, __ATOMIC_RELAXED);
+}
+
+const char *pw_channel_name(pw_channel_t channel)
+{
+	if (channel >= PW_CHANNEL_COUNT) {
+		return "unknown";
+	}
+	return CHANNEL_NAMES[channel];
+}
+
+bool pw_channel_from_name(const char *name, pw_channel_t *out)
+{
+	uint32_t ch;
+
+	for (ch = 0; ch < PW_CHANNEL_COUNT; ++ch) {
+		if (strcmp(CHANNEL_NAMES[ch], name) == 0) {
+			*out = ch;
+			return true;
+		}
+	}
+	return false;
+}
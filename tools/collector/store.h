@@ -0,0 +1,84 @@
+#ifndef _PICOWEATHER_COLLECTOR_STORE_H
+#define _PICOWEATHER_COLLECTOR_STORE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "wire.h"
+
+/* Per station time series.
+ *
+ * Every station has one ring per channel, allocated on its first sample.
+ * Rings are columnar: timestamps and values live in separate arrays so
+ * aggregates only stream through the column they need.
+ *
+ * Stations are found through an open addressing table. Lookups are lock
+ * free; only inserting a new station takes the table lock. Each station
+ * has its own lock shared by its appends and queries.
+ */
+
+struct pw_series {
+	uint32_t head;
+	uint32_t count;
+	uint64_t ingest_ns_last;
+	uint32_t *timestamps_ms;
+	int32_t *values;
+};
+typedef struct pw_series pw_series_t;
+
+struct pw_station {
+	uint32_t id;
+	pthread_mutex_t lock;
+	pw_series_t *series[PW_CHANNEL_COUNT];
+};
+typedef struct pw_station pw_station_t;
+
+struct pw_store {
+	pw_station_t **slots;
+	uint32_t slots_len;
+	uint32_t ring_len;
+	uint32_t stations;
+	pthread_mutex_t insert_lock;
+};
+typedef struct pw_store pw_store_t;
+
+struct pw_sample {
+	uint64_t ingest_ns;
+	uint32_t timestamp_ms;
+	int32_t value;
+};
+typedef struct pw_sample pw_sample_t;
+
+struct pw_aggregate {
+	uint32_t count;
+	int32_t min;
+	int32_t max;
+	int64_t sum;
+};
+typedef struct pw_aggregate pw_aggregate_t;
+
+/* max_stations and ring_len are rounded up to powers of two */
+bool pw_store_init(pw_store_t *store, uint32_t max_stations,
+		   uint32_t ring_len);
+void pw_store_destroy(pw_store_t *store);
+
+/* Returns NULL if the station is unknown and create is false, or if the
+ * table is full.
+ */
+pw_station_t *pw_store_station(pw_store_t *store, uint32_t id, bool create);
+bool pw_store_append(pw_store_t *store, pw_station_t *station,
+		     const pw_record_t *record, uint64_t ingest_ns);
+
+bool pw_store_latest(pw_store_t *store, uint32_t station, pw_channel_t channel,
+		     pw_sample_t *out);
+/* Aggregates the samples within window_ms of the newest one */
+bool pw_store_window(pw_store_t *store, uint32_t station, pw_channel_t channel,
+		     uint32_t window_ms, pw_aggregate_t *out);
+uint32_t pw_store_station_count(pw_store_t *store);
+
+const char *pw_channel_name(pw_channel_t channel);
+bool pw_channel_from_name(const char *name, pw_channel_t *out);
+
+#endif /* _PICOWEATHER_COLLECTOR_STORE_H */
@@ -0,0 +1,354 @@
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "ingest.h"
+#include "pool.h"
+#include "store.h"
+#include "wire.h"
+
+/* Runs the receivers, pool and store together, fed over loopback UDP and
+ * through a FIFO in place of a tty.
+ */
+
+#define TEST_WAIT_MS (2000)
+#define TEST_TTY_STATION (9)
+
+struct test_collector {
+	pw_store_t store;
+	pw_pool_t pool;
+	pw_ingest_t ingest;
+};
+
+static bool collector_start(struct test_collector *c)
+{
+	if (!pw_store_init(&c->store, 64, 16)) {
+		return false;
+	}
+	// The UDP thread holds a batch of buffers while it waits
+	if (!pw_pool_init(&c->pool, &c->store, 2, 64)) {
+		pw_store_destroy(&c->store);
+		return false;
+	}
+	pw_ingest_init(&c->ingest, &c->pool, &c->store);
+	return true;
+}
+
+static void collector_stop(struct test_collector *c)
+{
+	pw_ingest_stop(&c->ingest);
+	pw_pool_stop(&c->pool);
+	pw_pool_destroy(&c->pool);
+	pw_store_destroy(&c->store);
+}
+
+/* Waits until the pool counted at least records and errors */
+static void collector_wait(struct test_collector *c, uint64_t records,
+			   uint64_t errors, pw_parse_stats_t *stats)
+{
+	uint64_t rejected;
+	uint32_t i;
+
+	for (i = 0; i < TEST_WAIT_MS; ++i) {
+		pw_pool_stats(&c->pool, stats, &rejected);
+		if (stats->records >= records && stats->errors >= errors) {
+			break;
+		}
+		usleep(1000);
+	}
+	// Anything beyond the expected counts would show up by now
+	usleep(10000);
+	pw_pool_stats(&c->pool, stats, &rejected);
+}
+
+static void expect_latest(pw_store_t *store, uint32_t station,
+			  pw_channel_t channel, uint32_t timestamp_ms,
+			  int32_t value)
+{
+	pw_sample_t sample = { 0 };
+
+	PW_CHECK(pw_store_latest(store, station, channel, &sample) &&
+			 sample.timestamp_ms == timestamp_ms &&
+			 sample.value == value,
+		 "station %u %s is %u/%d instead of %u/%d", station,
+		 pw_channel_name(channel), sample.timestamp_ms, sample.value,
+		 timestamp_ms, value);
+}
+
+static void frame_write(int fd, uint32_t station, uint32_t timestamp_ms,
+			int32_t value, size_t drop)
+{
+	pw_record_t record = {
+		.station = station,
+		.timestamp_ms = timestamp_ms,
+		.value = value,
+		.channel = PW_CHANNEL_LUX,
+	};
+	uint8_t frame[PW_WIRE_FRAME_LEN];
+	size_t len = PW_WIRE_FRAME_LEN;
+
+	pw_wire_encode(&record, frame);
+	// drop is the index of a byte lost on the wire, or the frame length
+	if (drop < len) {
+		memmove(frame + drop, frame + drop + 1, len - drop - 1);
+		--len;
+	}
+	PW_CHECK(write(fd, frame, len) == (ssize_t)len, "frame write failed");
+}
+
+static void text_write(int fd, const char *text)
+{
+	PW_CHECK(write(fd, text, strlen(text)) == (ssize_t)strlen(text),
+		 "text write failed");
+}
+
+/* Opens the writing end once the collector has the fifo open for reading */
+static int fifo_writer_open(const char *path)
+{
+	uint32_t i;
+	int fd = -1;
+
+	for (i = 0; i < TEST_WAIT_MS && fd < 0; ++i) {
+		fd = open(path, O_WRONLY | O_NONBLOCK);
+		if (fd < 0 && errno == ENXIO) {
+			usleep(1000);
+		}
+	}
+	PW_CHECK(fd >= 0, "failed to open %s for writing", path);
+	return fd;
+}
+
+static void fifo_make(char *dir, char *path, size_t path_len)
+{
+	PW_CHECK(mkdtemp(dir) != NULL, "mkdtemp failed");
+	snprintf(path, path_len, "%s/tty", dir);
+	PW_CHECK(mkfifo(path, 0600) == 0, "mkfifo failed");
+}
+
+/* A frame that lost a byte on the wire costs only that frame */
+static void test_tty(void)
+{
+	struct test_collector c;
+	pw_parse_stats_t stats;
+	char dir[] = "/tmp/pw_test_ingestXXXXXX";
+	char path[64];
+	int fd;
+
+	if (!collector_start(&c)) {
+		PW_CHECK(false, "collector failed to start");
+		return;
+	}
+	fifo_make(dir, path, sizeof(path));
+	// Adding must not wait for a writer
+	PW_CHECK(pw_ingest_tty_add(&c.ingest, path, TEST_TTY_STATION),
+		 "failed to add the fifo");
+	pw_ingest_start(&c.ingest);
+	fd = fifo_writer_open(path);
+
+	text_write(fd, "[100ms] UV Index: 1.23\r\n");
+	frame_write(fd, 1, 110, 1000, PW_WIRE_FRAME_LEN);
+	frame_write(fd, 1, 120, 1200, 9);
+	frame_write(fd, 2, 130, 2000, PW_WIRE_FRAME_LEN);
+	text_write(fd, "@3 [140ms] Lux: 3.00\n[150ms] Lux: 4.");
+	usleep(20000);
+	text_write(fd, "50\n");
+	frame_write(fd, 1, 160, 1600, PW_WIRE_FRAME_LEN);
+
+	collector_wait(&c, 6, 1, &stats);
+	PW_CHECK(stats.records == 6 && stats.errors == 1,
+		 "%llu records and %llu errors",
+		 (unsigned long long)stats.records,
+		 (unsigned long long)stats.errors);
+	expect_latest(&c.store, TEST_TTY_STATION, PW_CHANNEL_UV_INDEX, 100,
+		      123);
+	expect_latest(&c.store, TEST_TTY_STATION, PW_CHANNEL_LUX, 150, 450);
+	expect_latest(&c.store, 1, PW_CHANNEL_LUX, 160, 1600);
+	expect_latest(&c.store, 2, PW_CHANNEL_LUX, 130, 2000);
+	expect_latest(&c.store, 3, PW_CHANNEL_LUX, 140, 300);
+
+	collector_stop(&c);
+	close(fd);
+	unlink(path);
+	rmdir(dir);
+}
+
+/* A tty that went away is read again once it is back */
+static void test_tty_reopen(void)
+{
+	struct test_collector c;
+	pw_parse_stats_t stats;
+	char dir[] = "/tmp/pw_test_ingestXXXXXX";
+	char path[64];
+	int fd;
+
+	if (!collector_start(&c)) {
+		PW_CHECK(false, "collector failed to start");
+		return;
+	}
+	fifo_make(dir, path, sizeof(path));
+	PW_CHECK(pw_ingest_tty_add(&c.ingest, path, TEST_TTY_STATION),
+		 "failed to add the fifo");
+	pw_ingest_start(&c.ingest);
+
+	fd = fifo_writer_open(path);
+	text_write(fd, "[100ms] Lux: 1.00\n");
+	collector_wait(&c, 1, 0, &stats);
+	// The reader sees the end of the stream and closes its end
+	close(fd);
+	usleep(50000);
+	fd = fifo_writer_open(path);
+	text_write(fd, "[200ms] Lux: 2.00\n");
+
+	collector_wait(&c, 2, 0, &stats);
+	PW_CHECK(stats.records == 2 && stats.errors == 0,
+		 "%llu records and %llu errors",
+		 (unsigned long long)stats.records,
+		 (unsigned long long)stats.errors);
+	expect_latest(&c.store, TEST_TTY_STATION, PW_CHANNEL_LUX, 200, 200);
+
+	collector_stop(&c);
+	close(fd);
+	unlink(path);
+	rmdir(dir);
+}
+
+static int udp_connect(uint16_t port)
+{
+	struct sockaddr_in addr = { 0 };
+	int fd;
+
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd >= 0 &&
+	    connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+		close(fd);
+		fd = -1;
+	}
+	return fd;
+}
+
+static void udp_send(int fd, const void *data, size_t len)
+{
+	PW_CHECK(send(fd, data, len, 0) == (ssize_t)len, "send failed");
+}
+
+/* The sender's address doesn't make a station id */
+static void test_udp(void)
+{
+	static const char text_anonymous[] = "[1ms] Lux: 1.00\n";
+	static const char text_named[] = "@5 [2ms] Lux: 2.00";
+	struct test_collector c;
+	pw_parse_stats_t stats;
+	pw_record_t record = {
+		.station = 6,
+		.timestamp_ms = 3,
+		.value = 300,
+		.channel = PW_CHANNEL_LUX,
+	};
+	uint8_t frame[PW_WIRE_FRAME_LEN];
+	uint16_t port = 0;
+	int fd;
+
+	if (!collector_start(&c)) {
+		PW_CHECK(false, "collector failed to start");
+		return;
+	}
+	PW_CHECK(pw_ingest_udp_open(&c.ingest, "127.0.0.1", &port),
+		 "failed to open the UDP socket");
+	pw_ingest_start(&c.ingest);
+	fd = udp_connect(port);
+	PW_CHECK(fd >= 0, "failed to connect");
+
+	udp_send(fd, text_anonymous, sizeof(text_anonymous) - 1);
+	udp_send(fd, text_named, sizeof(text_named) - 1);
+	pw_wire_encode(&record, frame);
+	udp_send(fd, frame, sizeof(frame));
+
+	collector_wait(&c, 2, 1, &stats);
+	PW_CHECK(stats.records == 2 && stats.errors == 1,
+		 "%llu records and %llu errors",
+		 (unsigned long long)stats.records,
+		 (unsigned long long)stats.errors);
+	PW_CHECK(pw_store_station_count(&c.store) == 2, "%u stations",
+		 pw_store_station_count(&c.store));
+	expect_latest(&c.store, 5, PW_CHANNEL_LUX, 2, 200);
+	expect_latest(&c.store, 6, PW_CHANNEL_LUX, 3, 300);
+
+	close(fd);
+	collector_stop(&c);
+}
+
+/* Fills a datagram with readings, padded to len with a line that isn't
+ * one. Returns the number of readings.
+ */
+static uint32_t datagram_fill(char *data, size_t len)
+{
+	static const char line[] = "@7 [1ms] Lux: 1.00\n";
+	uint32_t readings = 0;
+	size_t off = 0;
+
+	while (len - off >= 2 * (sizeof(line) - 1)) {
+		memcpy(data + off, line, sizeof(line) - 1);
+		off += sizeof(line) - 1;
+		++readings;
+	}
+	memset(data + off, '-', len - off - 1);
+	data[len - 1] = '\n';
+	return readings;
+}
+
+/* A datagram that didn't fit a buffer is dropped, not parsed in part */
+static void test_udp_truncated(void)
+{
+	static char data[PW_BUF_SIZE + 100];
+	struct test_collector c;
+	pw_parse_stats_t stats;
+	uint32_t readings;
+	uint16_t port = 0;
+	int fd;
+
+	if (!collector_start(&c)) {
+		PW_CHECK(false, "collector failed to start");
+		return;
+	}
+	PW_CHECK(pw_ingest_udp_open(&c.ingest, "127.0.0.1", &port),
+		 "failed to open the UDP socket");
+	pw_ingest_start(&c.ingest);
+	fd = udp_connect(port);
+	PW_CHECK(fd >= 0, "failed to connect");
+
+	(void)datagram_fill(data, sizeof(data));
+	udp_send(fd, data, sizeof(data));
+	readings = datagram_fill(data, PW_BUF_SIZE);
+	udp_send(fd, data, PW_BUF_SIZE);
+
+	collector_wait(&c, readings, 1, &stats);
+	PW_CHECK(stats.records == readings && stats.errors == 1,
+		 "%llu records and %llu errors, expected %u records",
+		 (unsigned long long)stats.records,
+		 (unsigned long long)stats.errors, readings);
+
+	close(fd);
+	collector_stop(&c);
+}
+
+int main(void)
+{
+	test_tty();
+	test_tty_reopen();
+	test_udp();
+	test_udp_truncated();
+	return pw_check_result();
+}
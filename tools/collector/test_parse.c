@@ -0,0 +1,293 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "check.h"
+#include "parse.h"
+#include "wire.h"
+
+#define TEST_RECORDS_MAX (64)
+#define TEST_STREAM_MAX (1024)
+#define TEST_TTY_STATION (9)
+
+struct test_sink {
+	pw_record_t records[TEST_RECORDS_MAX];
+	uint32_t len;
+	pw_parse_stats_t stats;
+};
+
+struct test_stream {
+	char data[TEST_STREAM_MAX];
+	size_t len;
+};
+
+static void test_emit(void *ctx, const pw_record_t *record)
+{
+	struct test_sink *sink = ctx;
+
+	if (sink->len < TEST_RECORDS_MAX) {
+		sink->records[sink->len++] = *record;
+	}
+}
+
+static void stream_text(struct test_stream *stream, const char *text)
+{
+	memcpy(stream->data + stream->len, text, strlen(text));
+	stream->len += strlen(text);
+}
+
+static void stream_frame(struct test_stream *stream, uint32_t station,
+			 uint32_t timestamp_ms, int32_t value)
+{
+	pw_record_t record = {
+		.station = station,
+		.timestamp_ms = timestamp_ms,
+		.value = value,
+		.channel = PW_CHANNEL_LUX,
+	};
+
+	pw_wire_encode(&record, (uint8_t *)stream->data + stream->len);
+	stream->len += PW_WIRE_FRAME_LEN;
+}
+
+static void stream_drop(struct test_stream *stream, size_t off)
+{
+	memmove(stream->data + off, stream->data + off + 1,
+		stream->len - off - 1);
+	--stream->len;
+}
+
+/* Feeds the stream in reads of chunk bytes, carrying what the parser
+ * leaves over the way a worker does for a tty. Returns the bytes left over.
+ */
+static size_t feed(const struct test_stream *stream, size_t chunk,
+		   struct test_sink *sink)
+{
+	char buf[TEST_STREAM_MAX];
+	size_t len = 0;
+	size_t off = 0;
+	size_t n;
+	size_t consumed;
+
+	memset(sink, 0, sizeof(*sink));
+	while (off < stream->len) {
+		n = stream->len - off < chunk ? stream->len - off : chunk;
+		memcpy(buf + len, stream->data + off, n);
+		off += n;
+		len += n;
+		consumed = pw_parse_stream(buf, len, TEST_TTY_STATION,
+					   test_emit, sink, &sink->stats);
+		len -= consumed;
+		memmove(buf, buf + consumed, len);
+	}
+	return len;
+}
+
+static void expect_records(const char *name, const struct test_sink *sink,
+			   const pw_record_t *expected, uint32_t len,
+			   uint64_t errors, size_t chunk)
+{
+	uint32_t i;
+
+	PW_CHECK(sink->len == len && sink->stats.records == len,
+		 "%s, %zu byte reads: %u records instead of %u", name, chunk,
+		 sink->len, len);
+	PW_CHECK(sink->stats.errors == errors,
+		 "%s, %zu byte reads: %llu errors instead of %llu", name,
+		 chunk, (unsigned long long)sink->stats.errors,
+		 (unsigned long long)errors);
+	for (i = 0; i < len && i < sink->len; ++i) {
+		PW_CHECK(sink->records[i].station == expected[i].station &&
+				 sink->records[i].timestamp_ms ==
+					 expected[i].timestamp_ms &&
+				 sink->records[i].value == expected[i].value &&
+				 sink->records[i].channel ==
+					 expected[i].channel,
+			 "%s, %zu byte reads: record %u is %u/%u/%d", name,
+			 chunk, i, sink->records[i].station,
+			 sink->records[i].timestamp_ms,
+			 sink->records[i].value);
+	}
+}
+
+/* Every read size must give the same records as parsing it in one go */
+static void expect_stream(const char *name, const struct test_stream *stream,
+			  const pw_record_t *expected, uint32_t len,
+			  uint64_t errors, size_t left)
+{
+	struct test_sink sink;
+	size_t chunk;
+	size_t got;
+
+	for (chunk = 1; chunk <= stream->len; ++chunk) {
+		got = feed(stream, chunk, &sink);
+		expect_records(name, &sink, expected, len, errors, chunk);
+		PW_CHECK(got == left, "%s, %zu byte reads: %zu bytes left",
+			 name, chunk, got);
+	}
+}
+
+#define LUX(st, ts, v) { (st), (ts), (v), PW_CHANNEL_LUX }
+
+/* A frame missing one byte costs that frame, not the rest of the stream */
+static void test_dropped_byte(void)
+{
+	static const pw_record_t expected[] = {
+		LUX(1, 10, 100), LUX(3, 30, 300), LUX(4, 40, 400),
+		LUX(5, 50, 500),
+	};
+	struct test_stream stream = { 0 };
+	uint32_t i;
+
+	for (i = 1; i <= 5; ++i) {
+		stream_frame(&stream, i, i * 10, i * 100);
+	}
+	// Out of the station id of the second frame
+	stream_drop(&stream, PW_WIRE_FRAME_LEN + 5);
+	expect_stream("dropped byte", &stream, expected, 4, 1, 0);
+
+	/* Out of the magic. The frame is never recognized so there is no
+	 * error, its bytes are skipped like any text cut short by a frame.
+	 */
+	memset(&stream, 0, sizeof(stream));
+	for (i = 1; i <= 5; ++i) {
+		stream_frame(&stream, i, i * 10, i * 100);
+	}
+	stream_drop(&stream, PW_WIRE_FRAME_LEN + 1);
+	expect_stream("dropped magic byte", &stream, expected, 4, 0, 0);
+}
+
+static void test_mixed(void)
+{
+	static const pw_record_t expected[] = {
+		{ TEST_TTY_STATION, 100, 123, PW_CHANNEL_UV_INDEX },
+		LUX(1, 110, 1000),
+		LUX(7, 200, 500),
+		LUX(2, 210, 2000),
+		LUX(3, 220, 3000),
+		{ TEST_TTY_STATION, 300, 42, PW_CHANNEL_UV_DOSE },
+		LUX(5, 400, 5000),
+		LUX(TEST_TTY_STATION, 500, 100),
+	};
+	struct test_stream stream = { 0 };
+
+	stream_text(&stream, "[100ms] UV Index: 1.23\r\n");
+	stream_frame(&stream, 1, 110, 1000);
+	stream_text(&stream, "@7 [200ms] Lux: 5.00\n");
+	stream_frame(&stream, 2, 210, 2000);
+	stream_frame(&stream, 3, 220, 3000);
+	// Not readings, the P must not be taken for a frame
+	stream_text(&stream, "[250ms] Health bh1750: misses 0\n");
+	stream_text(&stream, "Press any key\n");
+	stream_text(&stream, "[300ms] UV Dose: 42 mJ/m^2\n");
+	// A frame with a flipped CRC byte
+	stream_frame(&stream, 4, 310, 4000);
+	stream.data[stream.len - 1] ^= 0x01;
+	stream_frame(&stream, 5, 400, 5000);
+	// A partial line and a partial frame are left for the next read
+	stream_text(&stream, "[500ms] Lux: 1");
+	expect_stream("mixed", &stream, expected, 7, 1, 14);
+
+	stream_text(&stream, "\n");
+	stream_frame(&stream, 6, 600, 6000);
+	stream.len -= 3;
+	expect_stream("mixed with a partial frame", &stream, expected, 8, 1,
+		      PW_WIRE_FRAME_LEN - 3);
+}
+
+/* The start of a magic at the end of a read may still become a frame */
+static void test_partial_magic(void)
+{
+	struct test_sink sink = { 0 };
+	const char *lines[] = { "[1ms] Lux: 1\nP", "[1ms] Lux: 1\nPW" };
+	size_t i;
+
+	for (i = 0; i < sizeof(lines) / sizeof(lines[0]); ++i) {
+		PW_CHECK(pw_parse_stream(lines[i], strlen(lines[i]), 1,
+					 test_emit, &sink, &sink.stats) ==
+				 strlen("[1ms] Lux: 1\n"),
+			 "partial magic %zu consumed", i);
+	}
+	PW_CHECK(sink.stats.errors == 0, "%llu errors",
+		 (unsigned long long)sink.stats.errors);
+}
+
+/* Without a station to fall back on, only "@<station>" lines and frames
+ * are credited to a station
+ */
+static void test_station_none(void)
+{
+	static const char text[] = "@5 [1ms] Lux: 1\n"
+				   "[2ms] Lux: 2\n"
+				   "[3ms] Health bh1750: misses 0\n"
+				   "@4294967295 [4ms] Lux: 4\n";
+	struct test_sink sink = { 0 };
+	struct test_stream stream = { 0 };
+
+	PW_CHECK(pw_parse(text, sizeof(text) - 1, PW_STATION_NONE, test_emit,
+			  &sink, &sink.stats) == sizeof(text) - 1,
+		 "text not consumed");
+	PW_CHECK(sink.len == 1 && sink.records[0].station == 5,
+		 "%u records", sink.len);
+	PW_CHECK(sink.stats.errors == 2, "%llu errors",
+		 (unsigned long long)sink.stats.errors);
+
+	stream_frame(&stream, PW_STATION_NONE, 10, 100);
+	stream_frame(&stream, 6, 20, 200);
+	memset(&sink, 0, sizeof(sink));
+	PW_CHECK(pw_parse(stream.data, stream.len, PW_STATION_NONE, test_emit,
+			  &sink, &sink.stats) == stream.len,
+		 "frames not consumed");
+	PW_CHECK(sink.len == 1 && sink.records[0].station == 6,
+		 "%u records", sink.len);
+	PW_CHECK(sink.stats.errors == 1, "%llu errors",
+		 (unsigned long long)sink.stats.errors);
+}
+
+/* Counts errors the way a worker does for a datagram, where anything
+ * left over is another error
+ */
+static uint64_t datagram_errors(const struct test_stream *stream,
+				struct test_sink *sink)
+{
+	memset(sink, 0, sizeof(*sink));
+	if (pw_parse(stream->data, stream->len, 1, test_emit, sink,
+		     &sink->stats) != stream->len) {
+		++sink->stats.errors;
+	}
+	return sink->stats.errors;
+}
+
+/* One bad datagram is one error, even if a magic turns up in its tail */
+static void test_corrupt_datagram(void)
+{
+	struct test_stream stream = { 0 };
+	struct test_sink sink;
+
+	stream_frame(&stream, 1, 10, 100);
+	stream.data[PW_WIRE_FRAME_LEN - 4] = PW_WIRE_MAGIC0;
+	stream.data[PW_WIRE_FRAME_LEN - 1] ^= 0x01;
+	PW_CHECK(datagram_errors(&stream, &sink) == 1 && sink.len == 0,
+		 "corrupt frame: %llu errors, %u records",
+		 (unsigned long long)sink.stats.errors, sink.len);
+
+	// A frame cut short after a good one
+	memset(&stream, 0, sizeof(stream));
+	stream_frame(&stream, 1, 10, 100);
+	stream_frame(&stream, 2, 20, 200);
+	stream.len -= 3;
+	PW_CHECK(datagram_errors(&stream, &sink) == 1 && sink.len == 1,
+		 "partial frame: %llu errors, %u records",
+		 (unsigned long long)sink.stats.errors, sink.len);
+}
+
+int main(void)
+{
+	test_dropped_byte();
+	test_mixed();
+	test_partial_magic();
+	test_station_none();
+	test_corrupt_datagram();
+	return pw_check_result();
+}
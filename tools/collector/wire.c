@@ -0,0 +1,52 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "wire.h"
+
+inline static void put_u32(uint8_t *p, uint32_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+inline static uint32_t get_u32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+	       ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void pw_wire_encode(const pw_record_t *record, uint8_t *frame)
+{
+	frame[0] = PW_WIRE_MAGIC0;
+	frame[1] = PW_WIRE_MAGIC1;
+	frame[2] = PW_WIRE_VERSION;
+	frame[3] = record->channel;
+	put_u32(frame + 4, record->station);
+	put_u32(frame + 8, record->timestamp_ms);
+	put_u32(frame + 12, (uint32_t)record->value);
+	frame[16] = crc8(frame, 16, PW_WIRE_CRC8_INIT, PW_WIRE_CRC8_POLY,
+			 PW_WIRE_CRC8_XOR);
+}
+
+bool pw_wire_decode(const uint8_t *frame, pw_record_t *record)
+{
+	if (frame[0] != PW_WIRE_MAGIC0 || frame[1] != PW_WIRE_MAGIC1 ||
+	    frame[2] != PW_WIRE_VERSION || frame[3] >= PW_CHANNEL_COUNT) {
+		return false;
+	}
+	// crc8() takes a non-const buffer but doesn't write to it
+	if (crc8((uint8_t *)frame, 16, PW_WIRE_CRC8_INIT, PW_WIRE_CRC8_POLY,
+		 PW_WIRE_CRC8_XOR) != frame[16]) {
+		return false;
+	}
+	record->station = get_u32(frame + 4);
+	if (record->station == PW_STATION_NONE) {
+		return false;
+	}
+	record->channel = frame[3];
+	record->timestamp_ms = get_u32(frame + 8);
+	record->value = (int32_t)get_u32(frame + 12);
+	return true;
+}
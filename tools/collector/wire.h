@@ -0,0 +1,58 @@
+#ifndef _PICOWEATHER_COLLECTOR_WIRE_H
+#define _PICOWEATHER_COLLECTOR_WIRE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pw_snapshot.h"
+
+/* Binary reading frame. A datagram or stream may hold any number of them
+ * back to back. All fields are little endian.
+ *
+ *   0  'P'
+ *   1  'W'
+ *   2  version (PW_WIRE_VERSION)
+ *   3  channel (enum pw_channel)
+ *   4  station id, u32
+ *   8  timestamp, u32 ms since the station booted
+ *   12 value, i32 in the channel's fixed point unit (see pw_snapshot.h)
+ *   16 CRC-8 of bytes 0-15
+ *
+ * The CRC uses the same parameters as the SGP30 so crc8() from the
+ * firmware can be shared.
+ */
+
+#define PW_WIRE_MAGIC0 ('P')
+#define PW_WIRE_MAGIC1 ('W')
+#define PW_WIRE_VERSION (1)
+#define PW_WIRE_FRAME_LEN (17)
+#define PW_WIRE_CRC8_INIT ((uint8_t)0xFF)
+#define PW_WIRE_CRC8_POLY ((uint8_t)0x31)
+#define PW_WIRE_CRC8_XOR ((uint8_t)0x00)
+
+/* Reserved, never a station. Frames carrying it are rejected. */
+#define PW_STATION_NONE (UINT32_MAX)
+
+struct pw_record {
+	uint32_t station;
+	uint32_t timestamp_ms;
+	int32_t value;
+	pw_channel_t channel;
+};
+typedef struct pw_record pw_record_t;
+
+/* src/crc.c */
+uint8_t crc8(uint8_t msg[], size_t length, uint8_t init, uint8_t poly,
+	     uint8_t xor);
+
+void pw_wire_encode(const pw_record_t *record, uint8_t *frame);
+bool pw_wire_decode(const uint8_t *frame, pw_record_t *record);
+
+inline static bool pw_wire_is_binary(const char *buf, size_t len)
+{
+	return len >= 3 && buf[0] == PW_WIRE_MAGIC0 &&
+	       buf[1] == PW_WIRE_MAGIC1 && buf[2] == PW_WIRE_VERSION;
+}
+
+#endif /* _PICOWEATHER_COLLECTOR_WIRE_H */
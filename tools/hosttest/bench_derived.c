@@ -0,0 +1,68 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "pw_derived.h"
+
+#define BENCH_UPDATES_DEFAULT (10000000)
+
+inline static uint64_t bench_clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+inline static uint64_t bench_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+/* Cost of one pw_derived_thermo_update() with inputs that change every
+ * call, so nothing is skipped. Usage: bench_derived [updates]
+ */
+int main(int argc, char **argv)
+{
+	uint32_t updates = BENCH_UPDATES_DEFAULT;
+	pw_derived_state_t state;
+	volatile uint32_t sink = 0;
+	uint64_t start_ns;
+	uint64_t start_cycles;
+	uint64_t ns;
+	uint64_t cycles;
+	uint32_t i;
+
+	if (argc > 1) {
+		updates = strtoul(argv[1], NULL, 0);
+	}
+	if (updates == 0) {
+		return 1;
+	}
+	pw_derived_init(&state);
+	start_ns = bench_clock_ns();
+	start_cycles = bench_cycles();
+	for (i = 0; i < updates; ++i) {
+		// Walk through most of the table and the whole RH range
+		sink += pw_derived_thermo_update(&state,
+						 -3000 + (int32_t)(i % 11000),
+						 (i * 7) % 10001);
+	}
+	cycles = bench_cycles() - start_cycles;
+	ns = bench_clock_ns() - start_ns;
+	printf("%u thermo updates: %.1f ns/update", updates,
+	       (double)ns / updates);
+	if (cycles != 0) {
+		printf(", %.0f TSC cycles/update", (double)cycles / updates);
+	}
+	printf("\n");
+	return 0;
+}
@@ -0,0 +1,95 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "pw_snapshot.h"
+
+#define BENCH_OPS_DEFAULT (10000000)
+
+struct bench_reader {
+	pthread_t thread;
+	uint64_t reads;
+};
+
+static bool bench_stopping = false;
+
+inline static uint64_t bench_clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void *bench_reader_main(void *arg)
+{
+	struct bench_reader *reader = arg;
+	pw_snapshot_t snapshot;
+
+	while (!__atomic_load_n(&bench_stopping, __ATOMIC_ACQUIRE)) {
+		(void)pw_snapshot_read(&snapshot);
+		++reader->reads;
+	}
+	return NULL;
+}
+
+static double bench_publish(uint32_t ops)
+{
+	uint64_t start_ns = bench_clock_ns();
+	uint32_t i;
+
+	for (i = 0; i < ops; ++i) {
+		pw_snapshot_set(i % PW_CHANNEL_COUNT, i, i);
+		pw_snapshot_publish();
+	}
+	return (double)(bench_clock_ns() - start_ns) / ops;
+}
+
+static double bench_read(uint32_t ops, bool whole)
+{
+	pw_snapshot_t snapshot;
+	pw_reading_t reading;
+	uint64_t start_ns = bench_clock_ns();
+	uint32_t i;
+
+	for (i = 0; i < ops; ++i) {
+		if (whole) {
+			(void)pw_snapshot_read(&snapshot);
+		} else {
+			(void)pw_snapshot_read_channel(i % PW_CHANNEL_COUNT,
+						       &reading);
+		}
+	}
+	return (double)(bench_clock_ns() - start_ns) / ops;
+}
+
+/* Latency of publishing and reading the snapshot, alone and with a reader
+ * hammering it from another thread. Usage: bench_snapshot [ops]
+ */
+int main(int argc, char **argv)
+{
+	uint32_t ops = BENCH_OPS_DEFAULT;
+	struct bench_reader reader = { 0 };
+	double publish_ns;
+
+	if (argc > 1) {
+		ops = strtoul(argv[1], NULL, 0);
+	}
+	if (ops == 0) {
+		return 1;
+	}
+	printf("uncontended: publish %.1f ns, read %.1f ns, read channel %.1f ns\n",
+	       bench_publish(ops), bench_read(ops, true),
+	       bench_read(ops, false));
+
+	pthread_create(&reader.thread, NULL, bench_reader_main, &reader);
+	publish_ns = bench_publish(ops);
+	__atomic_store_n(&bench_stopping, true, __ATOMIC_RELEASE);
+	pthread_join(reader.thread, NULL);
+	printf("with a concurrent reader: publish %.1f ns, %llu reads\n",
+	       publish_ns, (unsigned long long)reader.reads);
+	return 0;
+}
@@ -0,0 +1,32 @@
+#ifndef _PICOWEATHER_HOSTTEST_CHECK_H
+#define _PICOWEATHER_HOSTTEST_CHECK_H
+
+#include <stdio.h>
+
+/* Every test is its own executable. Failed checks are printed and
+ * counted, and main() returns pw_check_result() so ctest sees them.
+ */
+
+static int pw_check_failures = 0;
+
+#define PW_CHECK(cond, ...)                                           \
+	do {                                                          \
+		if (!(cond)) {                                        \
+			++pw_check_failures;                          \
+			fprintf(stderr, "%s:%d: check failed: %s: ", \
+				__FILE__, __LINE__, #cond);           \
+			fprintf(stderr, __VA_ARGS__);                 \
+			fputc('\n', stderr);                          \
+		}                                                     \
+	} while (0)
+
+inline static int pw_check_result(void)
+{
+	if (pw_check_failures != 0) {
+		fprintf(stderr, "%d checks failed.\n", pw_check_failures);
+		return 1;
+	}
+	return 0;
+}
+
+#endif /* _PICOWEATHER_HOSTTEST_CHECK_H */
@@ -0,0 +1,17 @@
+#ifndef _PICOWEATHER_SENSOR_LIST_H
+#define _PICOWEATHER_SENSOR_LIST_H
+
+/* Simulated registry for test_sched. Its include path has sim/ ahead of
+ * src/, so pw_sensors.h picks this up instead of src/pw_sensor_list.h.
+ *
+ * instant: read right after its start, like the S12SD.
+ * converting: its start reports 40ms instead of the 30ms given here, like
+ *             the BH1750 after an MTreg change.
+ */
+#define PW_SENSORS(X)                                    \
+	X(instant, PW_BUS_ADC, 0, 26, 100, 0)            \
+	X(converting, PW_BUS_I2C, 0, 0x23, 250, 30000)
+
+#define SIM_CONVERTING_CONV_US (40000)
+
+#endif /* _PICOWEATHER_SENSOR_LIST_H */
@@ -0,0 +1,136 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <hardware/adc.h>
+#include <hardware/gpio.h>
+#include <hardware/i2c.h>
+#include <hardware/structs/watchdog.h>
+#include <hardware/watchdog.h>
+#include <pico/error.h>
+#include <pico/time.h>
+
+#include "stub.h"
+
+uint64_t stub_time_us = 0;
+
+uint16_t stub_adc_raw = 0;
+
+bool stub_i2c_hung = false;
+uint32_t stub_i2c_read_nacks = 0;
+uint8_t stub_i2c_read_byte = 0;
+
+bool stub_watchdog_caused_reboot = false;
+bool stub_watchdog_enabled = false;
+uint32_t stub_watchdog_delay_ms = 0;
+uint64_t stub_watchdog_fed_us = 0;
+uint32_t stub_watchdog_feeds = 0;
+
+i2c_inst_t i2c0_inst = { .n = 0 };
+i2c_inst_t i2c1_inst = { .n = 1 };
+
+static watchdog_hw_t stub_watchdog_regs = { 0 };
+watchdog_hw_t *watchdog_hw = &stub_watchdog_regs;
+
+absolute_time_t get_absolute_time(void)
+{
+	return stub_time_us;
+}
+
+void adc_init(void)
+{
+}
+
+void adc_gpio_init(uint gpio)
+{
+	(void)gpio;
+}
+
+void adc_select_input(uint input)
+{
+	(void)input;
+}
+
+uint16_t adc_read(void)
+{
+	return stub_adc_raw;
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn)
+{
+	(void)gpio;
+	(void)fn;
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate)
+{
+	(void)i2c;
+	return baudrate;
+}
+
+uint i2c_set_baudrate(i2c_inst_t *i2c, uint baudrate)
+{
+	(void)i2c;
+	return baudrate;
+}
+
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src,
+			 size_t len, bool nostop, uint timeout_us)
+{
+	(void)i2c;
+	(void)addr;
+	(void)src;
+	(void)nostop;
+	if (stub_i2c_hung) {
+		stub_time_us += timeout_us;
+		return PICO_ERROR_TIMEOUT;
+	}
+	stub_time_us += STUB_I2C_XFER_US;
+	return len;
+}
+
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst,
+			size_t len, bool nostop, uint timeout_us)
+{
+	(void)i2c;
+	(void)addr;
+	(void)nostop;
+	if (stub_i2c_hung) {
+		stub_time_us += timeout_us;
+		return PICO_ERROR_TIMEOUT;
+	}
+	stub_time_us += STUB_I2C_XFER_US;
+	if (stub_i2c_read_nacks != 0) {
+		--stub_i2c_read_nacks;
+		return PICO_ERROR_GENERIC;
+	}
+	memset(dst, stub_i2c_read_byte, len);
+	return len;
+}
+
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug)
+{
+	(void)pause_on_debug;
+	stub_watchdog_enabled = true;
+	stub_watchdog_delay_ms = delay_ms;
+	stub_watchdog_fed_us = stub_time_us;
+}
+
+void watchdog_update(void)
+{
+	stub_watchdog_fed_us = stub_time_us;
+	++stub_watchdog_feeds;
+}
+
+bool watchdog_enable_caused_reboot(void)
+{
+	return stub_watchdog_caused_reboot;
+}
+
+bool stub_watchdog_expired(void)
+{
+	return stub_watchdog_enabled &&
+	       stub_time_us - stub_watchdog_fed_us >
+		       (uint64_t)stub_watchdog_delay_ms * 1000;
+}
@@ -0,0 +1,38 @@
+#ifndef _PICOWEATHER_HOSTTEST_STUB_H
+#define _PICOWEATHER_HOSTTEST_STUB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Controls for the stubbed Pico SDK in stub.c.
+ *
+ * Time only moves when a test advances stub_time_us or a stubbed transfer
+ * takes time, so every run sees the same timeline.
+ */
+
+extern uint64_t stub_time_us;
+
+/* ADC */
+extern uint16_t stub_adc_raw;
+
+/* I2C. A working transfer takes STUB_I2C_XFER_US and reads return
+ * stub_i2c_read_byte. While stub_i2c_hung is set every transfer burns
+ * its whole timeout and returns PICO_ERROR_TIMEOUT, like a bus held low.
+ * Each stub_i2c_read_nacks fails the next read with PICO_ERROR_GENERIC.
+ */
+#define STUB_I2C_XFER_US (100)
+
+extern bool stub_i2c_hung;
+extern uint32_t stub_i2c_read_nacks;
+extern uint8_t stub_i2c_read_byte;
+
+/* Watchdog. The stub never resets, it records when it would have. */
+extern bool stub_watchdog_caused_reboot;
+extern bool stub_watchdog_enabled;
+extern uint32_t stub_watchdog_delay_ms;
+extern uint64_t stub_watchdog_fed_us;
+extern uint32_t stub_watchdog_feeds;
+
+bool stub_watchdog_expired(void);
+
+#endif /* _PICOWEATHER_HOSTTEST_STUB_H */
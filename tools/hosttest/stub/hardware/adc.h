@@ -0,0 +1,13 @@
+#ifndef _PICOWEATHER_HOSTTEST_HARDWARE_ADC_H
+#define _PICOWEATHER_HOSTTEST_HARDWARE_ADC_H
+
+#include <stdint.h>
+
+#include <pico/types.h>
+
+void adc_init(void);
+void adc_gpio_init(uint gpio);
+void adc_select_input(uint input);
+uint16_t adc_read(void);
+
+#endif /* _PICOWEATHER_HOSTTEST_HARDWARE_ADC_H */
@@ -0,0 +1,12 @@
+#ifndef _PICOWEATHER_HOSTTEST_HARDWARE_GPIO_H
+#define _PICOWEATHER_HOSTTEST_HARDWARE_GPIO_H
+
+#include <pico/types.h>
+
+enum gpio_function {
+	GPIO_FUNC_I2C = 3,
+};
+
+void gpio_set_function(uint gpio, enum gpio_function fn);
+
+#endif /* _PICOWEATHER_HOSTTEST_HARDWARE_GPIO_H */
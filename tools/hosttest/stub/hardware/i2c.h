@@ -0,0 +1,24 @@
+#ifndef _PICOWEATHER_HOSTTEST_HARDWARE_I2C_H
+#define _PICOWEATHER_HOSTTEST_HARDWARE_I2C_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pico/types.h>
+
+typedef struct i2c_inst {
+	uint n;
+} i2c_inst_t;
+
+extern i2c_inst_t i2c0_inst;
+extern i2c_inst_t i2c1_inst;
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+uint i2c_set_baudrate(i2c_inst_t *i2c, uint baudrate);
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src,
+			 size_t len, bool nostop, uint timeout_us);
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst,
+			size_t len, bool nostop, uint timeout_us);
+
+#endif /* _PICOWEATHER_HOSTTEST_HARDWARE_I2C_H */
@@ -0,0 +1,16 @@
+#ifndef _PICOWEATHER_HOSTTEST_HARDWARE_STRUCTS_WATCHDOG_H
+#define _PICOWEATHER_HOSTTEST_HARDWARE_STRUCTS_WATCHDOG_H
+
+#include <stdint.h>
+
+typedef struct {
+	volatile uint32_t ctrl;
+	volatile uint32_t load;
+	volatile uint32_t reason;
+	volatile uint32_t scratch[8];
+	volatile uint32_t tick;
+} watchdog_hw_t;
+
+extern watchdog_hw_t *watchdog_hw;
+
+#endif /* _PICOWEATHER_HOSTTEST_HARDWARE_STRUCTS_WATCHDOG_H */
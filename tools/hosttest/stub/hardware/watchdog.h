@@ -0,0 +1,11 @@
+#ifndef _PICOWEATHER_HOSTTEST_HARDWARE_WATCHDOG_H
+#define _PICOWEATHER_HOSTTEST_HARDWARE_WATCHDOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug);
+void watchdog_update(void);
+bool watchdog_enable_caused_reboot(void);
+
+#endif /* _PICOWEATHER_HOSTTEST_HARDWARE_WATCHDOG_H */
@@ -0,0 +1,10 @@
+#ifndef _PICOWEATHER_HOSTTEST_PICO_ERROR_H
+#define _PICOWEATHER_HOSTTEST_PICO_ERROR_H
+
+enum pico_error_codes {
+	PICO_OK = 0,
+	PICO_ERROR_GENERIC = -1,
+	PICO_ERROR_TIMEOUT = -2,
+};
+
+#endif /* _PICOWEATHER_HOSTTEST_PICO_ERROR_H */
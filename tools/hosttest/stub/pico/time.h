@@ -0,0 +1,30 @@
+#ifndef _PICOWEATHER_HOSTTEST_PICO_TIME_H
+#define _PICOWEATHER_HOSTTEST_PICO_TIME_H
+
+#include <pico/types.h>
+
+/* Backed by the fake clock in stub.c */
+absolute_time_t get_absolute_time(void);
+
+inline static uint64_t to_us_since_boot(absolute_time_t t)
+{
+	return t;
+}
+
+inline static uint32_t to_ms_since_boot(absolute_time_t t)
+{
+	return t / 1000;
+}
+
+inline static absolute_time_t from_us_since_boot(uint64_t us)
+{
+	return us;
+}
+
+inline static int64_t absolute_time_diff_us(absolute_time_t from,
+					    absolute_time_t to)
+{
+	return (int64_t)(to - from);
+}
+
+#endif /* _PICOWEATHER_HOSTTEST_PICO_TIME_H */
@@ -0,0 +1,29 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pw_health.h"
+
+/* No-op health tracking for tests of the modules that report to it. The
+ * real pw_health.c is tested on its own in test_health.
+ */
+
+void pw_health_init(uint64_t now_us)
+{
+	(void)now_us;
+}
+
+void pw_health_op(pw_sensor_id_t id, uint64_t due_us, uint64_t begin_us,
+		  uint64_t end_us, bool ok)
+{
+	(void)id;
+	(void)due_us;
+	(void)begin_us;
+	(void)end_us;
+	(void)ok;
+}
+
+void pw_health_progress(pw_sensor_id_t id, uint64_t now_us)
+{
+	(void)id;
+	(void)now_us;
+}
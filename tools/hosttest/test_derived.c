@@ -0,0 +1,251 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "check.h"
+#include "pw_derived.h"
+
+/* Bounds promised in pw_derived.h */
+#define DEW_POINT_ERR_MAX_C (0.11)
+#define ABS_HUM_ERR_REL_MAX (0.008)
+#define ABS_HUM_ERR_ABS_MAX (1.0 / 256)
+#define HEAT_INDEX_ERR_MAX_C (0.15)
+// Both sides of the 80F switch are skipped within this margin
+#define HEAT_INDEX_SWITCH_MARGIN_F (0.05)
+
+/* Double precision versions of the formulas the tables approximate */
+
+static double ref_es_pa(double t)
+{
+	return 611.2 * exp(17.62 * t / (243.12 + t));
+}
+
+static double ref_dew_point_c(double t, double rh)
+{
+	double g = log(rh / 100.0) + 17.62 * t / (243.12 + t);
+
+	return 243.12 * g / (17.62 - g);
+}
+
+static double ref_abs_hum_gpm3(double t, double rh)
+{
+	return 2.16679 * ref_es_pa(t) * rh / 100.0 / (t + 273.15);
+}
+
+static double ref_heat_index_simple_f(double tf, double rh)
+{
+	return 0.5 * (tf + 61.0 + (tf - 68.0) * 1.2 + rh * 0.094);
+}
+
+static double ref_heat_index_c(double t, double rh)
+{
+	double tf = t * 9.0 / 5.0 + 32.0;
+	double hi = ref_heat_index_simple_f(tf, rh);
+
+	if ((hi + tf) / 2.0 >= 80.0) {
+		hi = -42.379 + 2.04901523 * tf + 10.14333127 * rh -
+		     0.22475541 * tf * rh - 0.00683783 * tf * tf -
+		     0.05481717 * rh * rh + 0.00122874 * tf * tf * rh +
+		     0.00085282 * tf * rh * rh - 0.00000199 * tf * tf * rh * rh;
+		if (rh < 13.0 && tf > 80.0 && tf < 112.0) {
+			hi -= (13.0 - rh) / 4.0 *
+			      sqrt((17.0 - fabs(tf - 95.0)) / 17.0);
+		} else if (rh > 85.0 && tf > 80.0 && tf < 87.0) {
+			hi += (rh - 85.0) / 10.0 * ((87.0 - tf) / 5.0);
+		}
+	}
+	return (hi - 32.0) * 5.0 / 9.0;
+}
+
+struct derived_err {
+	double dew_point_c;
+	double abs_hum_rel;
+	double heat_index_c;
+};
+
+static void check_dew_point(int32_t temp_centi_c, uint32_t rh_centi,
+			    struct derived_err *err_max)
+{
+	double t = temp_centi_c / 100.0;
+	double rh = rh_centi / 100.0;
+	double ref = ref_dew_point_c(t, rh);
+	double err;
+
+	// Clamped, see test_clamp()
+	if (ref < PW_DERIVED_T_MIN_CENTI_C / 100.0) {
+		return;
+	}
+	err = fabs(pw_derived_dew_point_centi_c(temp_centi_c, rh_centi) /
+			   100.0 -
+		   ref);
+	if (err > err_max->dew_point_c) {
+		err_max->dew_point_c = err;
+	}
+	PW_CHECK(err <= DEW_POINT_ERR_MAX_C,
+		 "dew point off by %.3fC at %.2fC %.2f%%", err, t, rh);
+}
+
+static void check_abs_hum(int32_t temp_centi_c, uint32_t rh_centi,
+			  struct derived_err *err_max)
+{
+	double t = temp_centi_c / 100.0;
+	double rh = rh_centi / 100.0;
+	double ref = ref_abs_hum_gpm3(t, rh);
+	uint16_t ah_q8 = pw_derived_abs_hum_gpm3_q8(temp_centi_c, rh_centi);
+	double err;
+
+	// Beyond what 8.8 fixed point can hold
+	if (ref >= 256.0) {
+		PW_CHECK(ah_q8 == UINT16_MAX,
+			 "absolute humidity doesn't saturate at %.2fC %.2f%%",
+			 t, rh);
+		return;
+	}
+	err = fabs(ah_q8 / 256.0 - ref);
+	PW_CHECK(err <= ABS_HUM_ERR_REL_MAX * ref + ABS_HUM_ERR_ABS_MAX,
+		 "absolute humidity off by %.4fg/m^3 (%.2f%%) at %.2fC %.2f%%",
+		 err, err / ref * 100, t, rh);
+	// Only where the LSB doesn't dominate
+	if (ref >= 1.0 && err / ref > err_max->abs_hum_rel) {
+		err_max->abs_hum_rel = err / ref;
+	}
+}
+
+static void check_heat_index(int32_t temp_centi_c, uint32_t rh_centi,
+			     struct derived_err *err_max)
+{
+	double t = temp_centi_c / 100.0;
+	double rh = rh_centi / 100.0;
+	double tf = t * 9.0 / 5.0 + 32.0;
+	double err;
+
+	if (fabs((ref_heat_index_simple_f(tf, rh) + tf) / 2.0 - 80.0) <
+	    HEAT_INDEX_SWITCH_MARGIN_F) {
+		return;
+	}
+	err = fabs(pw_derived_heat_index_centi_c(temp_centi_c, rh_centi) /
+			   100.0 -
+		   ref_heat_index_c(t, rh));
+	if (err > err_max->heat_index_c) {
+		err_max->heat_index_c = err;
+	}
+	PW_CHECK(err <= HEAT_INDEX_ERR_MAX_C,
+		 "heat index off by %.3fC at %.2fC %.2f%%", err, t, rh);
+}
+
+static void test_against_reference(void)
+{
+	struct derived_err err_max = { 0 };
+	int32_t temp_centi_c;
+	uint32_t rh_centi;
+
+	// Odd steps so the grid doesn't line up with the table
+	for (temp_centi_c = PW_DERIVED_T_MIN_CENTI_C;
+	     temp_centi_c <= PW_DERIVED_T_MAX_CENTI_C; temp_centi_c += 7) {
+		for (rh_centi = 100; rh_centi <= 10000; rh_centi += 37) {
+			check_dew_point(temp_centi_c, rh_centi, &err_max);
+			check_abs_hum(temp_centi_c, rh_centi, &err_max);
+			check_heat_index(temp_centi_c, rh_centi, &err_max);
+		}
+	}
+	printf("max error: dew point %.3fC, absolute humidity %.3f%% (>= 1g/m^3), heat index %.3fC\n",
+	       err_max.dew_point_c, err_max.abs_hum_rel * 100,
+	       err_max.heat_index_c);
+}
+
+static void test_clamp(void)
+{
+	// The real dew point here is about -76C
+	PW_CHECK(pw_derived_dew_point_centi_c(-4000, 100) ==
+			 PW_DERIVED_T_MIN_CENTI_C,
+		 "dew point at -40C 1%% is %d",
+		 pw_derived_dew_point_centi_c(-4000, 100));
+	PW_CHECK(pw_derived_dew_point_centi_c(-6000, 5000) ==
+			 PW_DERIVED_T_MIN_CENTI_C,
+		 "dew point below the table is %d",
+		 pw_derived_dew_point_centi_c(-6000, 5000));
+	// Saturated air at the top of the table
+	PW_CHECK(pw_derived_dew_point_centi_c(PW_DERIVED_T_MAX_CENTI_C, 10000) ==
+			 PW_DERIVED_T_MAX_CENTI_C,
+		 "dew point at 85C 100%% is %d",
+		 pw_derived_dew_point_centi_c(PW_DERIVED_T_MAX_CENTI_C, 10000));
+	PW_CHECK(pw_derived_dew_point_centi_c(9000, 10000) ==
+			 PW_DERIVED_T_MAX_CENTI_C,
+		 "dew point above the table is %d",
+		 pw_derived_dew_point_centi_c(9000, 10000));
+	// RH above 100% is treated as 100%
+	PW_CHECK(pw_derived_abs_hum_gpm3_q8(2500, 12000) ==
+			 pw_derived_abs_hum_gpm3_q8(2500, 10000),
+		 "RH isn't clamped");
+}
+
+static void test_thermo_update(void)
+{
+	pw_derived_state_t state;
+
+	pw_derived_init(&state);
+	PW_CHECK(pw_derived_thermo_update(&state, 2000, 5000),
+		 "first update must report a change");
+	PW_CHECK(!pw_derived_thermo_update(&state, 2000, 5000),
+		 "same inputs must not report a change");
+	PW_CHECK(state.dew_point_centi_c ==
+			 pw_derived_dew_point_centi_c(2000, 5000),
+		 "dew point not stored");
+	// 0 would turn the SGP30 compensation off
+	pw_derived_thermo_update(&state, PW_DERIVED_T_MIN_CENTI_C, 0);
+	PW_CHECK(state.abs_hum_gpm3_q8 == 1, "absolute humidity is %u",
+		 state.abs_hum_gpm3_q8);
+}
+
+static void test_uv_dose(void)
+{
+	pw_derived_state_t state;
+	uint32_t i;
+
+	pw_derived_init(&state);
+	// 5 UVI for an hour is 5 * 25mW/m^2 * 3600s
+	for (i = 0; i <= 3600; ++i) {
+		pw_derived_uv_update(&state, 500, (uint64_t)i * 1000000);
+	}
+	PW_CHECK(pw_derived_uv_dose_mj_m2(&state) == 450000,
+		 "dose is %d mJ/m^2", pw_derived_uv_dose_mj_m2(&state));
+
+	// A ramp from 0 to 10 UVI over 100s integrates to 5 UVI * 100s
+	pw_derived_init(&state);
+	for (i = 0; i <= 100; ++i) {
+		pw_derived_uv_update(&state, i * 10, (uint64_t)i * 1000000);
+	}
+	PW_CHECK(pw_derived_uv_dose_mj_m2(&state) == 12500,
+		 "ramp dose is %d mJ/m^2", pw_derived_uv_dose_mj_m2(&state));
+	// Time going backwards adds nothing
+	pw_derived_uv_update(&state, 1000, 0);
+	PW_CHECK(pw_derived_uv_dose_mj_m2(&state) == 12500,
+		 "dose changed to %d mJ/m^2", pw_derived_uv_dose_mj_m2(&state));
+
+	// A reset keeps the last sample, so 10 UVI for 10s lands in the window
+	pw_derived_uv_reset(&state, 50);
+	PW_CHECK(pw_derived_uv_dose_mj_m2(&state) == 0 &&
+			 state.uv_dose_start_us == 50,
+		 "dose is %d mJ/m^2 after a reset",
+		 pw_derived_uv_dose_mj_m2(&state));
+	pw_derived_uv_update(&state, 1000, 10000000);
+	PW_CHECK(pw_derived_uv_dose_mj_m2(&state) == 2500,
+		 "dose is %d mJ/m^2 after a reset",
+		 pw_derived_uv_dose_mj_m2(&state));
+
+	// 100 UVI for 10 days no longer fits, it must not wrap negative
+	pw_derived_init(&state);
+	pw_derived_uv_update(&state, 10000, 0);
+	pw_derived_uv_update(&state, 10000, 864000000000ULL);
+	PW_CHECK(pw_derived_uv_dose_mj_m2(&state) == INT32_MAX,
+		 "dose is %d mJ/m^2", pw_derived_uv_dose_mj_m2(&state));
+}
+
+int main(void)
+{
+	test_against_reference();
+	test_clamp();
+	test_thermo_update();
+	test_uv_dose();
+	return pw_check_result();
+}
@@ -0,0 +1,215 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <hardware/structs/watchdog.h>
+
+#include "check.h"
+#include "pw_cfg.h"
+#include "pw_health.h"
+#include "pw_log.h"
+#include "pw_sched.h"
+#include "pw_sensors.h"
+#include "pw_snapshot.h"
+#include "stub.h"
+
+/* Runs the real registry, drivers, scheduler and health tracking against
+ * the stubbed SDK in stub.c, driving them the way main() does.
+ */
+
+#define LOOP_ITERATIONS_MAX (1000000)
+
+/* Scratch register layout from pw_health.c */
+#define SCRATCH_MAGIC (0x5057U)
+#define RECORD_ID_SHIFT (27)
+#define RECORD_EVENT_SHIFT (25)
+#define RECORD_EVENT_MASK (0x3U)
+
+struct run_result {
+	bool watchdog_expired;
+	uint64_t watchdog_expired_at_us;
+};
+
+/* The main loop from main.c, sleeping by moving the fake clock */
+static struct run_result run_for(uint64_t duration_us)
+{
+	struct run_result result = { 0 };
+	uint64_t end_us = stub_time_us + duration_us;
+	uint64_t next_us;
+	uint64_t feed_us;
+	uint32_t i;
+
+	for (i = 0; i < LOOP_ITERATIONS_MAX && stub_time_us < end_us; ++i) {
+		next_us = pw_sched_poll(stub_time_us);
+		pw_snapshot_publish();
+		pw_health_poll(stub_time_us);
+		if (stub_watchdog_expired() && !result.watchdog_expired) {
+			result.watchdog_expired = true;
+			result.watchdog_expired_at_us = stub_time_us;
+		}
+		feed_us = stub_time_us + (uint64_t)HEALTH_FEED_PERIOD_MS * 1000;
+		next_us = next_us < feed_us ? next_us : feed_us;
+		if (next_us > stub_time_us) {
+			stub_time_us = next_us;
+		}
+	}
+	PW_CHECK(i < LOOP_ITERATIONS_MAX, "main loop never slept");
+	return result;
+}
+
+static pw_health_sensor_t health_get(pw_sensor_id_t id)
+{
+	return *pw_health_sensor_get(id);
+}
+
+static uint64_t lux_timestamp_us(void)
+{
+	pw_reading_t reading;
+
+	pw_snapshot_read_channel(PW_CHANNEL_LUX, &reading);
+	return reading.timestamp_us;
+}
+
+static uint32_t lux_timestamp_s(void)
+{
+	return lux_timestamp_us() / 1000000;
+}
+
+static void test_healthy(void)
+{
+	struct run_result result;
+	pw_health_sensor_t bh1750;
+	pw_health_sensor_t s12sd;
+	uint32_t feeds = stub_watchdog_feeds;
+
+	result = run_for(20000000);
+	bh1750 = health_get(PW_SENSOR_ID_bh1750);
+	s12sd = health_get(PW_SENSOR_ID_s12sd);
+	PW_CHECK(!result.watchdog_expired, "watchdog expired at %llums",
+		 (unsigned long long)result.watchdog_expired_at_us / 1000);
+	PW_CHECK(stub_watchdog_feeds - feeds >= 20000 / HEALTH_FEED_PERIOD_MS,
+		 "watchdog fed %u times in 20s", stub_watchdog_feeds - feeds);
+	PW_CHECK(bh1750.misses == 0 && bh1750.overruns == 0 &&
+			 bh1750.failures == 0,
+		 "bh1750: misses %u, overruns %u, failures %u", bh1750.misses,
+		 bh1750.overruns, bh1750.failures);
+	PW_CHECK(s12sd.misses == 0 && s12sd.overruns == 0 &&
+			 s12sd.failures == 0,
+		 "s12sd: misses %u, overruns %u, failures %u", s12sd.misses,
+		 s12sd.overruns, s12sd.failures);
+	PW_CHECK(lux_timestamp_s() + 2 >= stub_time_us / 1000000,
+		 "last lux reading at %us", lux_timestamp_s());
+}
+
+/* One NACKed read must cost one sample, not wedge the driver until the
+ * watchdog resets the board.
+ */
+static void test_transient_nack(void)
+{
+	struct run_result result;
+	uint32_t failures = health_get(PW_SENSOR_ID_bh1750).failures;
+
+	stub_i2c_read_nacks = 1;
+	result = run_for(20000000);
+	PW_CHECK(stub_i2c_read_nacks == 0, "the NACK was never hit");
+	PW_CHECK(health_get(PW_SENSOR_ID_bh1750).failures == failures + 1,
+		 "%u failures from a single NACK",
+		 health_get(PW_SENSOR_ID_bh1750).failures - failures);
+	PW_CHECK(!result.watchdog_expired,
+		 "watchdog expired at %llums after a single NACK",
+		 (unsigned long long)result.watchdog_expired_at_us / 1000);
+	PW_CHECK(lux_timestamp_s() + 2 >= stub_time_us / 1000000,
+		 "no lux reading since %us", lux_timestamp_s());
+}
+
+/* The bus hangs while a BH1750 measurement converts, so the read and
+ * everything after it fail. Every transfer burns BH1750_I2C_TIMEOUT_US,
+ * but the read with its recovery and every start must stay within their
+ * budget. The BH1750 stops progressing and the watchdog is left to expire
+ * once it stalls.
+ */
+static void test_hung_bus(void)
+{
+	pw_health_sensor_t before = health_get(PW_SENSOR_ID_bh1750);
+	pw_health_sensor_t after;
+	struct run_result result;
+	uint64_t hung_us;
+	uint64_t stall_us;
+
+	// The next start is a period after the last one, the read follows
+	hung_us = lux_timestamp_us() + (uint64_t)BH1750_PERIOD_MS * 1000 -
+		  pw_sensor_table[PW_SENSOR_ID_bh1750].conv_us / 2;
+	(void)run_for(hung_us - stub_time_us);
+	hung_us = stub_time_us;
+	stub_i2c_hung = true;
+	result = run_for(15000000);
+	stub_i2c_hung = false;
+	after = health_get(PW_SENSOR_ID_bh1750);
+
+	PW_CHECK(after.failures > before.failures, "no failures counted");
+	PW_CHECK(after.overruns == before.overruns, "%u overruns counted",
+		 after.overruns - before.overruns);
+	PW_CHECK(health_get(PW_SENSOR_ID_s12sd).failures == 0,
+		 "the ADC sensor was affected");
+	PW_CHECK(result.watchdog_expired, "watchdog never expired");
+	// Stall limit plus the watchdog timeout, plus up to one period
+	stall_us = (uint64_t)BH1750_PERIOD_MS * 1000 *
+			   (HEALTH_STALL_PERIODS + 1) +
+		   pw_sensor_table[PW_SENSOR_ID_bh1750].conv_us +
+		   HEALTH_DEADLINE_SLACK_US +
+		   (uint64_t)HEALTH_WATCHDOG_MS * 1000 +
+		   (uint64_t)HEALTH_FEED_PERIOD_MS * 1000;
+	PW_CHECK(result.watchdog_expired_at_us - hung_us <= stall_us,
+		 "watchdog expired %llums after the bus hung",
+		 (unsigned long long)(result.watchdog_expired_at_us - hung_us) /
+			 1000);
+}
+
+/* The record of the stall survives the reset in the scratch registers */
+static void test_reboot(void)
+{
+	uint32_t header = watchdog_hw->scratch[0];
+	uint32_t count = (header >> 8) & 0xff;
+	uint32_t head = header & 0xff;
+	uint32_t newest;
+
+	PW_CHECK(header >> 16 == SCRATCH_MAGIC, "scratch header is %08x",
+		 header);
+	PW_CHECK(count == 1, "%u records", count);
+	newest = watchdog_hw->scratch[1 + (head + HEALTH_SCRATCH_RECORDS - 1) %
+						  HEALTH_SCRATCH_RECORDS];
+	PW_CHECK(newest >> RECORD_ID_SHIFT == PW_SENSOR_ID_bh1750 &&
+			 ((newest >> RECORD_EVENT_SHIFT) & RECORD_EVENT_MASK) ==
+				 PW_HEALTH_EVENT_STALL,
+		 "newest record is %08x", newest);
+
+	// Logs the records, then starts over with an empty ring
+	stub_watchdog_caused_reboot = true;
+	pw_sched_init(stub_time_us);
+	PW_CHECK(watchdog_hw->scratch[0] == SCRATCH_MAGIC << 16,
+		 "scratch header is %08x after boot", watchdog_hw->scratch[0]);
+	PW_CHECK(health_get(PW_SENSOR_ID_bh1750).failures == 0,
+		 "counters not reset");
+	PW_CHECK(!run_for(10000000).watchdog_expired,
+		 "watchdog expired after the reboot");
+}
+
+int main(void)
+{
+	// Show what the firmware would log about the faults
+	pw_log_level_set(LOG_LEVEL_WARN);
+	// 1000 counts is about 0.8 UVI, 0x4000 raw is about 13653 lux
+	stub_adc_raw = 1000;
+	stub_i2c_read_byte = 0x40;
+	stub_time_us = 10000000;
+	pw_sched_init(stub_time_us);
+	PW_CHECK(stub_watchdog_enabled &&
+			 stub_watchdog_delay_ms == HEALTH_WATCHDOG_MS,
+		 "watchdog not enabled");
+
+	test_healthy();
+	test_transient_nack();
+	test_hung_bus();
+	test_reboot();
+	return pw_check_result();
+}
@@ -0,0 +1,213 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "check.h"
+#include "pw_sched.h"
+#include "pw_sensors.h"
+#include "stub.h"
+
+/* Runs pw_sched.c against the simulated registry in sim/pw_sensor_list.h
+ * and checks the exact start/read timeline on the fake clock.
+ */
+
+#define SIM_T0_US (1000000)
+#define SIM_EVENTS_MAX (64)
+
+enum sim_op {
+	SIM_OP_START = 0,
+	SIM_OP_READ,
+};
+
+struct sim_event {
+	pw_sensor_id_t id;
+	enum sim_op op;
+	uint64_t at_us;
+};
+
+static struct sim_event sim_events[SIM_EVENTS_MAX];
+static uint32_t sim_events_len = 0;
+static uint32_t sim_events_checked = 0;
+static uint32_t sim_converting_fail_starts = 0;
+static uint32_t sim_inits = 0;
+
+const pw_sensor_desc_t pw_sensor_table[PW_SENSOR_COUNT] = { PW_SENSORS(
+	PW_SENSOR_DESC) };
+
+static void sim_event(pw_sensor_id_t id, enum sim_op op, uint64_t now_us)
+{
+	PW_CHECK(now_us == stub_time_us,
+		 "%s op got now_us %llu but the clock is %llu",
+		 pw_sensor_table[id].name, (unsigned long long)now_us,
+		 (unsigned long long)stub_time_us);
+	if (sim_events_len < SIM_EVENTS_MAX) {
+		sim_events[sim_events_len++] = (struct sim_event){
+			.id = id,
+			.op = op,
+			.at_us = now_us,
+		};
+	}
+}
+
+void pw_sensors_init(void)
+{
+	uint32_t id;
+
+	for (id = 0; id < PW_SENSOR_COUNT; ++id) {
+		pw_sensor_init(id);
+	}
+}
+
+void pw_sensor_instant_init(void)
+{
+	++sim_inits;
+}
+
+bool pw_sensor_instant_start(uint64_t now_us, uint32_t *conv_us)
+{
+	PW_CHECK(*conv_us == 0, "instant got conv_us %u", *conv_us);
+	sim_event(PW_SENSOR_ID_instant, SIM_OP_START, now_us);
+	return true;
+}
+
+bool pw_sensor_instant_read(uint64_t now_us)
+{
+	sim_event(PW_SENSOR_ID_instant, SIM_OP_READ, now_us);
+	// An ADC conversion
+	stub_time_us += 50;
+	return true;
+}
+
+void pw_sensor_converting_init(void)
+{
+	++sim_inits;
+}
+
+bool pw_sensor_converting_start(uint64_t now_us, uint32_t *conv_us)
+{
+	PW_CHECK(*conv_us == 30000, "converting got conv_us %u", *conv_us);
+	sim_event(PW_SENSOR_ID_converting, SIM_OP_START, now_us);
+	// An I2C write
+	stub_time_us += 200;
+	if (sim_converting_fail_starts != 0) {
+		--sim_converting_fail_starts;
+		return false;
+	}
+	*conv_us = SIM_CONVERTING_CONV_US;
+	return true;
+}
+
+bool pw_sensor_converting_read(uint64_t now_us)
+{
+	sim_event(PW_SENSOR_ID_converting, SIM_OP_READ, now_us);
+	stub_time_us += 300;
+	return true;
+}
+
+static void expect_events(const char *phase, const struct sim_event *expected,
+			  uint32_t len)
+{
+	const struct sim_event *got;
+	uint32_t i;
+
+	PW_CHECK(sim_events_len - sim_events_checked == len,
+		 "%s: %u events instead of %u", phase,
+		 sim_events_len - sim_events_checked, len);
+	for (i = 0; i < len && sim_events_checked + i < sim_events_len; ++i) {
+		got = &sim_events[sim_events_checked + i];
+		PW_CHECK(got->id == expected[i].id &&
+				 got->op == expected[i].op &&
+				 got->at_us == expected[i].at_us,
+			 "%s: event %u is %s %s at %llu, expected %s %s at %llu",
+			 phase, i, pw_sensor_table[got->id].name,
+			 got->op == SIM_OP_START ? "start" : "read",
+			 (unsigned long long)got->at_us - SIM_T0_US,
+			 pw_sensor_table[expected[i].id].name,
+			 expected[i].op == SIM_OP_START ? "start" : "read",
+			 (unsigned long long)expected[i].at_us - SIM_T0_US);
+	}
+	sim_events_checked = sim_events_len;
+}
+
+/* Polls like main() does, jumping the clock to each returned time */
+static uint64_t run_until(uint64_t end_us)
+{
+	uint64_t next_us;
+
+	while (true) {
+		next_us = pw_sched_poll(stub_time_us);
+		PW_CHECK(next_us > stub_time_us,
+			 "next event %llu isn't in the future",
+			 (unsigned long long)next_us);
+		if (next_us > end_us || next_us <= stub_time_us) {
+			return next_us;
+		}
+		stub_time_us = next_us;
+	}
+}
+
+#define EV(name, op, t) { PW_SENSOR_ID_##name, SIM_OP_##op, SIM_T0_US + (t) }
+
+static void test_timeline(void)
+{
+	/* conv_us == 0 is read in the same poll, 50us later because of the
+	 * ADC. The converting sensor is read 40ms after its start finished,
+	 * not the 30ms from the registry.
+	 */
+	static const struct sim_event steady[] = {
+		EV(instant, START, 0),		EV(instant, READ, 0),
+		EV(converting, START, 50),	EV(converting, READ, 40250),
+		EV(instant, START, 100000),	EV(instant, READ, 100000),
+		EV(instant, START, 200000),	EV(instant, READ, 200000),
+		EV(converting, START, 250000),	EV(converting, READ, 290200),
+		EV(instant, START, 300000),	EV(instant, READ, 300000),
+	};
+	/* The loop stalls for almost a second. Each sensor starts once,
+	 * then its period restarts from the late start.
+	 */
+	static const struct sim_event late[] = {
+		EV(instant, START, 1234000),	EV(instant, READ, 1234000),
+		EV(converting, START, 1234050), EV(converting, READ, 1274250),
+		EV(instant, START, 1334000),	EV(instant, READ, 1334000),
+		EV(instant, START, 1434000),	EV(instant, READ, 1434000),
+		EV(converting, START, 1484050), EV(converting, READ, 1524250),
+	};
+	/* A failed start isn't read and is retried a period later */
+	static const struct sim_event failed[] = {
+		EV(instant, START, 1534000),	EV(instant, READ, 1534000),
+		EV(instant, START, 1634000),	EV(instant, READ, 1634000),
+		EV(instant, START, 1734000),	EV(instant, READ, 1734000),
+		EV(converting, START, 1734050), EV(instant, START, 1834000),
+		EV(instant, READ, 1834000),	EV(instant, START, 1934000),
+		EV(instant, READ, 1934000),	EV(converting, START, 1984050),
+		EV(converting, READ, 2024250),
+	};
+	uint64_t next_us;
+
+	stub_time_us = SIM_T0_US;
+	pw_sched_init(stub_time_us);
+	PW_CHECK(sim_inits == PW_SENSOR_COUNT, "%u sensors initialized",
+		 sim_inits);
+
+	next_us = run_until(SIM_T0_US + 300000);
+	expect_events("steady", steady, sizeof(steady) / sizeof(steady[0]));
+	PW_CHECK(next_us == SIM_T0_US + 400000, "next event at %llu",
+		 (unsigned long long)next_us - SIM_T0_US);
+
+	stub_time_us = SIM_T0_US + 1234000;
+	run_until(SIM_T0_US + 1524250);
+	expect_events("late", late, sizeof(late) / sizeof(late[0]));
+
+	sim_converting_fail_starts = 1;
+	next_us = run_until(SIM_T0_US + 2024250);
+	expect_events("failed", failed, sizeof(failed) / sizeof(failed[0]));
+	PW_CHECK(sim_converting_fail_starts == 0, "the failed start never ran");
+	PW_CHECK(next_us == SIM_T0_US + 2034000, "next event at %llu",
+		 (unsigned long long)next_us - SIM_T0_US);
+}
+
+int main(void)
+{
+	test_timeline();
+	return pw_check_result();
+}
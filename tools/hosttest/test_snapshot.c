@@ -0,0 +1,146 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "check.h"
+#include "pw_snapshot.h"
+
+#define TORTURE_READERS (3)
+#define TORTURE_PUBLISHES_DEFAULT (2000000)
+
+/* Torture test for the latched seqlock. The writer publishes generation g
+ * as value g and timestamp 3g on every channel, so any mix of two
+ * generations in one read is visible. Readers on other threads stand in
+ * for the other core.
+ */
+
+struct torture_reader {
+	pthread_t thread;
+	bool whole;
+	uint64_t reads;
+	uint64_t torn;
+	uint64_t seq_backwards;
+};
+
+static bool torture_stopping = false;
+
+inline static bool reading_torn(const pw_reading_t *reading, int32_t value)
+{
+	return reading->value != value ||
+	       reading->timestamp_us != (uint64_t)value * 3 || !reading->valid;
+}
+
+static void *torture_reader_main(void *arg)
+{
+	struct torture_reader *reader = arg;
+	pw_snapshot_t snapshot;
+	pw_reading_t reading;
+	uint32_t seq_last = 0;
+	uint32_t seq;
+	uint32_t i;
+
+	while (!__atomic_load_n(&torture_stopping, __ATOMIC_ACQUIRE)) {
+		++reader->reads;
+		if (reader->whole) {
+			seq = pw_snapshot_read(&snapshot);
+			for (i = 0; i < PW_CHANNEL_COUNT; ++i) {
+				if (reading_torn(&snapshot.readings[i],
+						 snapshot.readings[0].value)) {
+					++reader->torn;
+					break;
+				}
+			}
+		} else {
+			seq = pw_snapshot_read_channel(
+				reader->reads % PW_CHANNEL_COUNT, &reading);
+			if (reading_torn(&reading, reading.value)) {
+				++reader->torn;
+			}
+		}
+		if ((int32_t)(seq - seq_last) < 0) {
+			++reader->seq_backwards;
+		}
+		seq_last = seq;
+	}
+	return NULL;
+}
+
+static void publish_generation(int32_t generation)
+{
+	uint32_t i;
+
+	for (i = 0; i < PW_CHANNEL_COUNT; ++i) {
+		pw_snapshot_set(i, generation, (uint64_t)generation * 3);
+	}
+	pw_snapshot_publish();
+}
+
+static void test_torture(uint32_t publishes)
+{
+	struct torture_reader readers[TORTURE_READERS] = { 0 };
+	uint64_t reads = 0;
+	uint32_t g;
+	uint32_t i;
+
+	publish_generation(0);
+	for (i = 0; i < TORTURE_READERS; ++i) {
+		// Mix whole snapshot and single channel readers
+		readers[i].whole = i != 0;
+		pthread_create(&readers[i].thread, NULL, torture_reader_main,
+			       &readers[i]);
+	}
+	for (g = 1; g <= publishes; ++g) {
+		publish_generation(g);
+	}
+	__atomic_store_n(&torture_stopping, true, __ATOMIC_RELEASE);
+	for (i = 0; i < TORTURE_READERS; ++i) {
+		pthread_join(readers[i].thread, NULL);
+		reads += readers[i].reads;
+		PW_CHECK(readers[i].torn == 0, "reader %u saw %llu torn reads",
+			 i, (unsigned long long)readers[i].torn);
+		PW_CHECK(readers[i].seq_backwards == 0,
+			 "reader %u saw the sequence go back %llu times", i,
+			 (unsigned long long)readers[i].seq_backwards);
+	}
+	printf("%u publishes against %llu reads\n", publishes,
+	       (unsigned long long)reads);
+}
+
+static void test_staging(void)
+{
+	pw_snapshot_t snapshot;
+	pw_reading_t reading;
+	uint32_t seq;
+
+	seq = pw_snapshot_read(&snapshot);
+	// Staged values stay invisible until published
+	pw_snapshot_set(PW_CHANNEL_LUX, -1, 1);
+	pw_snapshot_invalidate(PW_CHANNEL_UV_INDEX);
+	PW_CHECK(pw_snapshot_read_channel(PW_CHANNEL_LUX, &reading) == seq,
+		 "sequence moved without a publish");
+	PW_CHECK(reading.value != -1, "staged value visible before publish");
+
+	pw_snapshot_publish();
+	PW_CHECK(pw_snapshot_read(&snapshot) == seq + 2,
+		 "publish must advance the sequence by 2");
+	PW_CHECK(snapshot.readings[PW_CHANNEL_LUX].value == -1 &&
+			 snapshot.readings[PW_CHANNEL_LUX].timestamp_us == 1,
+		 "published value missing");
+	PW_CHECK(!snapshot.readings[PW_CHANNEL_UV_INDEX].valid,
+		 "invalidated channel still valid");
+}
+
+/* Usage: test_snapshot [publishes] */
+int main(int argc, char **argv)
+{
+	uint32_t publishes = TORTURE_PUBLISHES_DEFAULT;
+
+	if (argc > 1) {
+		publishes = strtoul(argv[1], NULL, 0);
+	}
+	test_torture(publishes);
+	test_staging();
+	return pw_check_result();
+}